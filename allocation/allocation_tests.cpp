@@ -0,0 +1,148 @@
+/**
+  * \file allocation_tests.cpp
+  * \brief Catch tests counting the allocations of matrix operations. Built as an executable of its own,
+           from this file and the sources of the calculator except main.cpp, with the repository root
+           on the include path, as it replaces the global operator new and delete
+  */
+#define CATCH_CONFIG_MAIN
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "catch.hpp"
+#include "elementarymatrix.h"
+#include "calculator.h"
+
+namespace{
+
+  // Counts every allocation made through operator new, for tests on allocations of operations
+  std::atomic<std::size_t> allocations{0};
+
+  void* allocate(std::size_t size){
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+  }
+
+  void* allocate(std::size_t size, std::align_val_t align){
+    // Size of aligned_alloc is a multiple of the alignment
+    const std::size_t alignment = std::size_t(align);
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::aligned_alloc(alignment, (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment);
+  }
+
+  template <typename... A>
+  void* allocateOrThrow(A... args){
+    if(void* ptr = allocate(args...))
+      return ptr;
+    throw std::bad_alloc{};
+  }
+
+  /**
+    * \brief Returns number of allocations made by f
+    */
+  template <typename F>
+  std::size_t count(F&& f){
+    const std::size_t before = allocations.load();
+    f();
+    return allocations.load() - before;
+  }
+
+}
+
+// Every form of new and delete is replaced, so all memory is taken from and returned to malloc
+void* operator new(std::size_t size){ return allocateOrThrow(size); }
+void* operator new[](std::size_t size){ return allocateOrThrow(size); }
+void* operator new(std::size_t size, std::align_val_t align){ return allocateOrThrow(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align){ return allocateOrThrow(size, align); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept{ return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept{ return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept{ return allocate(size, align); }
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept{ return allocate(size, align); }
+
+void operator delete(void* ptr) noexcept{ std::free(ptr); }
+void operator delete[](void* ptr) noexcept{ std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept{ std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept{ std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept{ std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept{ std::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept{ std::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept{ std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept{ std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept{ std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept{ std::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept{ std::free(ptr); }
+
+/**
+  * \brief Tests that Calculator operations allocate only the elements of their result
+  */
+TEST_CASE("Calculator allocation tests", "[calculator]"){
+
+  const std::string ints = "[[2,3,4][5,6,7][8,9,10]]";
+  const std::string symbols = "[[x,2,3][4,y,6][7,8,z]]";
+
+  auto apply = [&](const std::string& left, char op){
+    Calculator calculator{};
+    calculator.push(SymbolicSquareMatrix{left});
+    calculator.push(SymbolicSquareMatrix{ints});
+    return count([&]{ calculator.apply(op); });
+  };
+
+  // Ints are folded inline, so sum and difference are computed in place without allocating
+  CHECK(apply(ints, '+') == 0);
+  CHECK(apply(ints, '-') == 0);
+
+  // Product of ints allocates only the one vector of cells it is computed into
+  CHECK(apply(ints, '*') == 1);
+
+  // First use creates the shared variable leaves and the table of composites
+  apply(symbols, '+');
+
+  // With expressions, x+2, y+6 and z+10 each allocate their int operand, composite and control block,
+  // into a new node list growing 1, 2, 4
+  CHECK(apply(symbols, '+') == 3 * 3 + 3);
+  CHECK(apply(symbols, '-') == 3 * 3 + 3);
+
+  Calculator calculator{};
+  calculator.push(SymbolicSquareMatrix{ints});
+  calculator.push(SymbolicSquareMatrix{ints});
+  calculator.apply('*');
+  CHECK(calculator.top() == SymbolicSquareMatrix{ints} * SymbolicSquareMatrix{ints});
+}
+
+/**
+  * \brief Tests that constructors and symbolic operations allocate only the storage they build
+  */
+TEST_CASE("ElementarySquareMatrix construction allocation tests", "[concretematrix][symbolicmatrix]"){
+
+  const std::size_t n = 3;
+  const std::string text = "[[x,2,3][4,y,6][7,8,z]]";
+  SymbolicSquareMatrix matrix{};
+
+  std::vector<std::vector<std::unique_ptr<Element>>> v = matrix.matrixIntoVector(text);
+  SymbolicSquareMatrix s{text};
+  SymbolicSquareMatrix ints{"[[2,3,4][5,6,7][8,9,10]]"};
+
+  // Ints and variables are stored inline, so matrices of them cost one vector of cells,
+  // like ConcreteSquareMatrix
+  CHECK(count([&]{ SymbolicSquareMatrix adopted{std::move(v)}; }) == 1);
+  CHECK(count([&]{ SymbolicSquareMatrix empty{n}; }) == 1);
+  CHECK(count([&]{ SymbolicSquareMatrix parsed{text}; }) == 1);
+  CHECK(count([&]{ SymbolicSquareMatrix transpose = s.transpose(); }) == 1);
+  CHECK(count([&]{ SymbolicSquareMatrix sum = ints + ints; }) == 1);
+  CHECK(count([&]{ SymbolicSquareMatrix identity = s.pow(0); }) == 1);
+
+  // First use creates the shared variable leaves and the table of composites
+  s + ints;
+
+  // Only cells holding expressions allocate: x+2, y+6 and z+10 each allocate their int operand,
+  // composite and control block, into a node list growing 1, 2, 4
+  CHECK(count([&]{ SymbolicSquareMatrix sum = s + ints; }) == 1 + n * 3 + 3);
+
+  // Composites that are still alive are shared instead of created again
+  const SymbolicSquareMatrix sum = s + ints;
+  CHECK(count([&]{ SymbolicSquareMatrix again = s + ints; }) == 1 + n + 3);
+
+  CHECK(sum.toString() == "[[(x+2),5,7][9,(y+6),13][15,17,(z+10)]]");
+  CHECK(s.pow(0) == SymbolicSquareMatrix{"[[1,0,0][0,1,0][0,0,1]]"});
+  CHECK(s.transpose().toString() == "[[x,4,7][2,y,8][3,6,z]]");
+}
@@ -0,0 +1,279 @@
+/**
+  * \file bytecode.cpp
+  * \brief Bytecode class
+  */
+
+#include <algorithm>
+#include <stdexcept>
+#include "bytecode.h"
+#include "valuationbatch.h"
+
+namespace{
+
+  // Programs at most this deep run without allocating a stack
+  constexpr std::size_t localStack = 64;
+
+  // Unsigned arithmetic gives the wrap around of int without undefined behaviour
+  inline int wrap(std::uint32_t v){
+    return int(v);
+  }
+
+  std::uint32_t power(std::uint32_t base, std::uint32_t e){
+    std::uint32_t result = 1;
+    for(; e != 0; e >>= 1){
+      if(e & 1)
+        result *= base;
+      base *= base;
+    }
+    return result;
+  }
+
+  // Valuations evaluated together in batch evaluation
+  constexpr std::size_t blockLanes = 64;
+
+  /**
+    * \brief Value of one stack slot or temporary for a block of valuations
+    */
+  struct alignas(64) Lanes{
+    std::uint32_t v[blockLanes];
+  };
+
+}
+
+void Bytecode::pushConstant(int value){
+
+  push(Opcode::Constant, value, 1);
+}
+
+void Bytecode::pushVariable(char name){
+
+  auto it = std::find(vars.begin(), vars.end(), name);
+  if(it == vars.end())
+    it = vars.insert(vars.end(), name);
+
+  push(Opcode::Variable, std::int32_t(it - vars.begin()), 1);
+}
+
+void Bytecode::pushOperation(char op){
+
+  switch(op){
+    case '+':
+      push(Opcode::Add, 0, -1);
+      break;
+    case '-':
+      push(Opcode::Subtract, 0, -1);
+      break;
+    case '*':
+      push(Opcode::Multiply, 0, -1);
+      break;
+    default:
+      throw std::invalid_argument{"Operation cannot be compiled."};
+  }
+}
+
+void Bytecode::pushMultiplyAdd(){
+
+  push(Opcode::MultiplyAdd, 0, -2);
+}
+
+void Bytecode::pushPower(std::uint32_t exponent){
+
+  push(Opcode::Power, std::int32_t(exponent), 0);
+}
+
+void Bytecode::store(std::size_t index){
+
+  push(Opcode::Store, std::int32_t(index), -1);
+}
+
+void Bytecode::save(const void* key){
+
+  auto it = temps.emplace(key, std::int32_t(temps.size())).first;
+  push(Opcode::Save, it->second, 0);
+}
+
+bool Bytecode::load(const void* key){
+
+  auto it = temps.find(key);
+  if(it == temps.end())
+    return false;
+
+  push(Opcode::Load, it->second, 1);
+  return true;
+}
+
+int Bytecode::evaluate(const Valuation& v) const{
+
+  int result = 0;
+  execute(v, nullptr, &result);
+  return result;
+}
+
+void Bytecode::evaluate(const Valuation& v, int* out) const{
+
+  execute(v, out, nullptr);
+}
+
+void Bytecode::evaluate(const ValuationBatch& batch, int* const* out) const{
+
+  // Columns are looked up once, throwing if a variable is not mapped in every valuation
+  std::vector<const int*> columns(vars.size());
+  for(std::size_t i = 0; i < vars.size(); i++){
+    columns[i] = batch.values(vars[i]);
+  }
+
+  std::vector<Lanes> stack(deepest);
+  std::vector<Lanes> saved(temps.size());
+
+  for(std::size_t base = 0; base < batch.size(); base += blockLanes){
+
+    // Lanes past the last valuation compute on zeroes and are never stored
+    const std::size_t width = std::min(blockLanes, batch.size() - base);
+    Lanes* top = stack.data() - 1;
+
+    for(const Instruction& ins : code){
+      switch(ins.op){
+        case Opcode::Constant:
+          top++;
+          for(std::size_t l = 0; l < blockLanes; l++)
+            top->v[l] = std::uint32_t(ins.operand);
+          break;
+        case Opcode::Variable:
+          top++;
+          for(std::size_t l = 0; l < width; l++)
+            top->v[l] = std::uint32_t(columns[ins.operand][base + l]);
+          for(std::size_t l = width; l < blockLanes; l++)
+            top->v[l] = 0;
+          break;
+        case Opcode::Add:
+          top--;
+          for(std::size_t l = 0; l < blockLanes; l++)
+            top->v[l] += top[1].v[l];
+          break;
+        case Opcode::Subtract:
+          top--;
+          for(std::size_t l = 0; l < blockLanes; l++)
+            top->v[l] -= top[1].v[l];
+          break;
+        case Opcode::Multiply:
+          top--;
+          for(std::size_t l = 0; l < blockLanes; l++)
+            top->v[l] *= top[1].v[l];
+          break;
+        case Opcode::MultiplyAdd:
+          top -= 2;
+          for(std::size_t l = 0; l < blockLanes; l++)
+            top->v[l] += top[1].v[l] * top[2].v[l];
+          break;
+        case Opcode::Power:{
+          // Squares every lane once per bit of the exponent
+          Lanes base = *top;
+          for(std::size_t l = 0; l < blockLanes; l++)
+            top->v[l] = 1;
+          for(std::uint32_t e = std::uint32_t(ins.operand); e != 0; e >>= 1){
+            if(e & 1){
+              for(std::size_t l = 0; l < blockLanes; l++)
+                top->v[l] *= base.v[l];
+            }
+            for(std::size_t l = 0; l < blockLanes; l++)
+              base.v[l] *= base.v[l];
+          }
+          break;
+        }
+        case Opcode::Store:
+          for(std::size_t l = 0; l < width; l++)
+            out[base + l][ins.operand] = wrap(top->v[l]);
+          top--;
+          break;
+        case Opcode::Save:
+          saved[ins.operand] = *top;
+          break;
+        case Opcode::Load:
+          *++top = saved[ins.operand];
+          break;
+      }
+    }
+  }
+}
+
+void Bytecode::push(Opcode op, std::int32_t operand, int depthChange){
+
+  // Operations pop one value more than they remove, Store, Save and Power need one
+  std::size_t needed = depthChange < 0 ? std::size_t(1 - depthChange) : 0;
+  if(op == Opcode::Store || op == Opcode::Save || op == Opcode::Power)
+    needed = 1;
+  if(depth < needed)
+    throw std::logic_error{"Not enough values on stack for instruction."};
+
+  code.push_back(Instruction{op, operand});
+  depth += depthChange;
+  deepest = std::max(deepest, depth);
+}
+
+void Bytecode::execute(const Valuation& v, int* out, int* bottom) const{
+
+  // Every variable is looked up once, throwing like VariableElement::evaluate if it is not mapped
+  std::vector<int> values(vars.size());
+  for(std::size_t i = 0; i < vars.size(); i++){
+    values[i] = v.at(vars[i]);
+  }
+
+  int local[localStack];
+  std::vector<int> heap;
+  int* stack = local;
+  if(deepest > localStack){
+    heap.resize(deepest);
+    stack = heap.data();
+  }
+
+  std::vector<int> saved(temps.size());
+
+  run(values.data(), stack, saved.data(), out);
+
+  if(bottom != nullptr && depth > 0)
+    *bottom = stack[0];
+}
+
+void Bytecode::run(const int* values, int* stack, int* saved, int* out) const{
+
+  int* top = stack - 1;
+
+  for(const Instruction& ins : code){
+    switch(ins.op){
+      case Opcode::Constant:
+        *++top = ins.operand;
+        break;
+      case Opcode::Variable:
+        *++top = values[ins.operand];
+        break;
+      case Opcode::Add:
+        top--;
+        top[0] = wrap(std::uint32_t(top[0]) + std::uint32_t(top[1]));
+        break;
+      case Opcode::Subtract:
+        top--;
+        top[0] = wrap(std::uint32_t(top[0]) - std::uint32_t(top[1]));
+        break;
+      case Opcode::Multiply:
+        top--;
+        top[0] = wrap(std::uint32_t(top[0]) * std::uint32_t(top[1]));
+        break;
+      case Opcode::MultiplyAdd:
+        top -= 2;
+        top[0] = wrap(std::uint32_t(top[0]) + std::uint32_t(top[1]) * std::uint32_t(top[2]));
+        break;
+      case Opcode::Power:
+        top[0] = wrap(power(std::uint32_t(top[0]), std::uint32_t(ins.operand)));
+        break;
+      case Opcode::Store:
+        out[ins.operand] = *top--;
+        break;
+      case Opcode::Save:
+        saved[ins.operand] = *top;
+        break;
+      case Opcode::Load:
+        *++top = saved[ins.operand];
+        break;
+    }
+  }
+}
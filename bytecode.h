@@ -0,0 +1,160 @@
+/**
+  * \file bytecode.h
+  * \brief Header for Bytecode class
+  */
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "valuation.h"
+
+class ValuationBatch;
+
+/**
+  * \class Bytecode
+  * \brief Element expressions lowered into a flat program for a stack machine.
+           Operations pop their operands and push the result, Store pops a result into an output slot.
+  */
+class Bytecode
+{
+public:
+
+  /**
+    * \brief Instructions of the stack machine
+    */
+  enum class Opcode : std::uint8_t{
+    Constant,     // Pushes operand
+    Variable,     // Pushes value of variable number operand
+    Add,
+    Subtract,
+    Multiply,
+    MultiplyAdd,  // Pops two values and adds their product to the value below
+    Power,        // Raises topmost value to power operand, read as unsigned
+    Store,        // Pops value into output number operand
+    Save,         // Copies topmost value into temporary number operand
+    Load          // Pushes temporary number operand
+  };
+
+  /**
+    * \brief One instruction and its operand
+    */
+  struct Instruction{
+    Opcode op;
+    std::int32_t operand;
+  };
+
+  /**
+    * \brief Appends instruction pushing constant
+    * \param value Constant to be pushed
+    */
+  void pushConstant(int value);
+
+  /**
+    * \brief Appends instruction pushing value of variable
+    * \param name Variable whose value is pushed
+    */
+  void pushVariable(char name);
+
+  /**
+    * \brief Appends arithmetic operation on two topmost values. Throws exception for unknown operation
+    * \param op Symbol for arithmetic operation, '+', '-' or '*'
+    */
+  void pushOperation(char op);
+
+  /**
+    * \brief Appends instruction adding the product of the two topmost values to the value below them,
+             so a term of a sum takes one instruction instead of two
+    */
+  void pushMultiplyAdd();
+
+  /**
+    * \brief Appends instruction raising the topmost value to a power. It runs by repeated squaring, so
+             large exponents cost one instruction and a logarithmic number of multiplications
+    * \param exponent Power, wrapping like repeated multiplication
+    */
+  void pushPower(std::uint32_t exponent);
+
+  /**
+    * \brief Appends instruction popping topmost value into output
+    * \param index Index of output
+    */
+  void store(std::size_t index);
+
+  /**
+    * \brief Appends instruction copying topmost value into a temporary, so that later instructions
+             can reuse the value of a shared subexpression instead of computing it again
+    * \param key Identifies the subexpression, usually its address
+    */
+  void save(const void* key);
+
+  /**
+    * \brief Appends instruction pushing value saved for key, if there is one
+    * \param key Identifies the subexpression, usually its address
+    * \return True if value was saved earlier and instruction was appended, else false
+    */
+  bool load(const void* key);
+
+  /**
+    * \brief Runs program that leaves one value on the stack
+    * \param v Map for char variables and int values. Throws exception if variable is not mapped
+    * \return Value left on the stack
+    */
+  int evaluate(const Valuation& v) const;
+
+  /**
+    * \brief Runs program writing its results to outputs
+    * \param v Map for char variables and int values. Throws exception if variable is not mapped
+    * \param out Outputs, needs room for every index given to store
+    */
+  void evaluate(const Valuation& v, int* out) const;
+
+  /**
+    * \brief Runs program once for every valuation of batch. Instructions are applied to blocks of
+             valuations at a time, so every instruction is decoded once per block and its arithmetic
+             runs across the block in SIMD lanes
+    * \param batch Valuations. Throws exception if a variable is not mapped in every valuation
+    * \param out Outputs for every valuation, out[i] needs room for every index given to store
+    */
+  void evaluate(const ValuationBatch& batch, int* const* out) const;
+
+  /**
+    * \brief Getter for instructions
+    * \return Instructions in execution order
+    */
+  const std::vector<Instruction>& instructions() const{
+    return code;
+  };
+
+  /**
+    * \brief Getter for variables
+    * \return Variables used by program, indexed by operand of Variable instructions
+    */
+  const std::vector<char>& variables() const{
+    return vars;
+  };
+
+  /**
+    * \brief Getter for stack depth
+    * \return Largest number of values on the stack while running program
+    */
+  std::size_t maxDepth() const{
+    return deepest;
+  };
+
+private:
+  void push(Opcode op, std::int32_t operand, int depthChange);
+  void execute(const Valuation& v, int* out, int* bottom) const;
+  void run(const int* values, int* stack, int* saved, int* out) const;
+
+  std::vector<Instruction> code;
+  std::vector<char> vars;
+  std::unordered_map<const void*, std::int32_t> temps;
+  std::size_t depth = 0;
+  std::size_t deepest = 0;
+
+};
+
+#endif // BYTECODE_H
@@ -0,0 +1,52 @@
+/**
+  * \file calculator.cpp
+  * \brief Calculator class
+  */
+
+#include <stdexcept>
+#include <utility>
+#include "calculator.h"
+
+void Calculator::push(SymbolicSquareMatrix&& m){
+
+  matrices.push_back(std::move(m));
+}
+
+void Calculator::apply(char op){
+
+  if(op != '+' && op != '-' && op != '*')
+    throw std::invalid_argument{"Unknown operation."};
+  if(matrices.size() < 2)
+    throw std::invalid_argument{"At least two matrices of same size needed for operation."};
+
+  SymbolicSquareMatrix& one = matrices[matrices.size() - 2];
+  const SymbolicSquareMatrix& two = matrices.back();
+
+  // Checked before one is consumed, so a failed operation loses no operands
+  one.checkOperands(two);
+
+  if(op == '+')
+    one = std::move(one) + two;
+  else if(op == '-')
+    one = std::move(one) - two;
+  else
+    one = std::move(one) * two;
+
+  matrices.pop_back();
+}
+
+void Calculator::power(unsigned int k){
+
+  if(matrices.empty())
+    throw std::out_of_range{"No matrices added."};
+
+  matrices.back() = matrices.back().pow(k);
+}
+
+const SymbolicSquareMatrix& Calculator::top(std::size_t depth) const{
+
+  if(depth >= matrices.size())
+    throw std::out_of_range{"Not enough matrices."};
+
+  return matrices[matrices.size() - 1 - depth];
+}
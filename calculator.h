@@ -0,0 +1,69 @@
+/**
+  * \file calculator.h
+  * \brief Header for Calculator class
+  */
+#ifndef CALCULATOR_H
+#define CALCULATOR_H
+
+#include <cstddef>
+#include <vector>
+#include "elementarymatrix.h"
+
+/**
+  * \class Calculator
+  * \brief Stack of SymbolicSquareMatrices for the reverse Polish calculator. Operands are moved, never
+           copied: the left operand is computed into in place on the stack with the rvalue operators,
+           and the right operand is popped afterwards, so an operation allocates only its result elements
+  */
+class Calculator
+{
+public:
+  /**
+    * \brief Moves matrix onto the top of the stack
+    * \param m SymbolicSquareMatrix to be added
+    */
+  void push(SymbolicSquareMatrix&& m);
+
+  /**
+    * \brief Replaces the two topmost matrices with the result of operation one op two, two being topmost.
+             Throws exception if op is not '+', '-' or '*', if there are fewer than two matrices or if
+             their sizes differ. The stack is unchanged when an exception is thrown
+    * \param op Operation
+    */
+  void apply(char op);
+
+  /**
+    * \brief Replaces the topmost matrix with its power k. Throws exception if the stack is empty
+    * \param k Exponent
+    */
+  void power(unsigned int k);
+
+  /**
+    * \brief Returns matrix at depth below the top. Throws std::out_of_range if there is no such matrix
+    * \param depth Number of matrices above, 0 for the topmost
+    * \return Reference to matrix, valid until the stack is changed
+    */
+  const SymbolicSquareMatrix& top(std::size_t depth = 0) const;
+
+  /**
+    * \brief Getter for number of matrices
+    * \return Number of matrices in stack
+    */
+  std::size_t size() const{
+    return matrices.size();
+  };
+
+  /**
+    * \brief Checks, if stack has no matrices
+    * \return True if stack is empty, else false
+    */
+  bool empty() const{
+    return matrices.empty();
+  };
+
+private:
+  std::vector<SymbolicSquareMatrix> matrices;
+
+};
+
+#endif // CALCULATOR_H
@@ -0,0 +1,202 @@
+/**
+  * \file cell.cpp
+  * \brief CellStorage and CellBuilder classes
+  */
+
+#include <typeinfo>
+#include "cell.h"
+#include "bytecode.h"
+#include "elementbuilder.h"
+#include "polynomialelement.h"
+
+namespace{
+
+  std::shared_ptr<const Element> materialize(Cell c, const CellNodes& nodes){
+
+    switch(c.kind()){
+      case Cell::Kind::Int:
+        return ElementBuilder::constant(c.value());
+      case Cell::Kind::Variable:
+        return ElementBuilder::variable(c.name());
+      default:
+        return nodes[c.index()];
+    }
+  }
+
+  bool isInt(Cell c, int value){
+    return c.kind() == Cell::Kind::Int && c.value() == value;
+  }
+
+  /**
+    * \brief Whether identities with int operands give the same result as ElementBuilder. They do unless
+             the cell is a polynomial, since polynomial arithmetic keeps results polynomials
+    */
+  bool plain(Cell c, const CellNodes& nodes){
+    return c.kind() != Cell::Kind::Node || dynamic_cast<const PolynomialElement*>(nodes[c.index()].get()) == nullptr;
+  }
+
+  // Folding wraps like evaluation does
+  Cell wrap(std::uint32_t value){
+    return Cell::integer(int(value));
+  }
+
+  /**
+    * \brief Stores ints and variables inline, returns false for other elements
+    */
+  bool inlined(const Element* e, Cell& c){
+
+    // Exact type checks, which are cheaper than failing casts on the composites most results are
+    const std::type_info& type = typeid(*e);
+    if(type == typeid(IntElement)){
+      c = Cell::integer(static_cast<const IntElement*>(e)->getVal());
+      return true;
+    }
+    if(type == typeid(VariableElement)){
+      c = Cell::variable(static_cast<const VariableElement*>(e)->getVal());
+      return true;
+    }
+    return false;
+  }
+
+  /**
+    * \brief Builds operation on Elements of cells and stores result in out
+    */
+  template <typename Operation>
+  Cell build(Cell c1, const CellNodes& nodes1, Cell c2, const CellNodes& nodes2, CellNodes& out, Operation op){
+
+    // Operands are materialized before out grows, since it may be one of the operand lists
+    const std::shared_ptr<const Element> e1 = materialize(c1, nodes1);
+    const std::shared_ptr<const Element> e2 = materialize(c2, nodes2);
+
+    return CellBuilder::adopt(op(e1, e2), out);
+  }
+
+}
+
+std::shared_ptr<const Element> CellStorage::element(Cell c) const{
+
+  return materialize(c, nodes);
+}
+
+void CellStorage::append(Cell c, std::string& s) const{
+
+  switch(c.kind()){
+    case Cell::Kind::Int:
+      s += std::to_string(c.value());
+      break;
+    case Cell::Kind::Variable:
+      s += c.name();
+      break;
+    default:
+      s += nodes[c.index()]->toString();
+  }
+}
+
+std::size_t CellStorage::hash(Cell c) const{
+
+  switch(c.kind()){
+    case Cell::Kind::Int:
+      return hashCombine(1, std::size_t(unsigned(c.value())));
+    case Cell::Kind::Variable:
+      return hashCombine(2, std::size_t(c.name()));
+    default:
+      return nodes[c.index()]->hash();
+  }
+}
+
+bool CellStorage::equal(Cell c, const CellStorage& other, Cell d) const{
+
+  // Node lists hold no ints or variables, so an inline cell never equals a node
+  if(c.kind() != Cell::Kind::Node || d.kind() != Cell::Kind::Node)
+    return c == d;
+
+  const std::shared_ptr<const Element>& a = nodes[c.index()];
+  const std::shared_ptr<const Element>& b = other.nodes[d.index()];
+
+  return a == b || *a == *b;
+}
+
+void CellStorage::compile(Cell c, Bytecode& code) const{
+
+  switch(c.kind()){
+    case Cell::Kind::Int:
+      code.pushConstant(c.value());
+      break;
+    case Cell::Kind::Variable:
+      code.pushVariable(c.name());
+      break;
+    default:
+      nodes[c.index()]->compile(code);
+  }
+}
+
+Cell CellBuilder::add(Cell c1, const CellNodes& nodes1, Cell c2, const CellNodes& nodes2, CellNodes& out){
+
+  if(c1.kind() == Cell::Kind::Int && c2.kind() == Cell::Kind::Int)
+    return wrap(std::uint32_t(c1.value()) + std::uint32_t(c2.value()));
+  if(isInt(c1, 0) && plain(c2, nodes2))
+    return copy(c2, nodes2, out);
+  if(isInt(c2, 0) && plain(c1, nodes1))
+    return copy(c1, nodes1, out);
+
+  return build(c1, nodes1, c2, nodes2, out, ElementBuilder::add);
+}
+
+Cell CellBuilder::subtract(Cell c1, const CellNodes& nodes1, Cell c2, const CellNodes& nodes2, CellNodes& out){
+
+  if(c1.kind() == Cell::Kind::Int && c2.kind() == Cell::Kind::Int)
+    return wrap(std::uint32_t(c1.value()) - std::uint32_t(c2.value()));
+  if(isInt(c2, 0) && plain(c1, nodes1))
+    return copy(c1, nodes1, out);
+  if(c1.kind() == Cell::Kind::Variable && c1 == c2)
+    return Cell::integer(0);
+
+  return build(c1, nodes1, c2, nodes2, out, ElementBuilder::subtract);
+}
+
+Cell CellBuilder::multiply(Cell c1, const CellNodes& nodes1, Cell c2, const CellNodes& nodes2, CellNodes& out){
+
+  if(c1.kind() == Cell::Kind::Int && c2.kind() == Cell::Kind::Int)
+    return wrap(std::uint32_t(c1.value()) * std::uint32_t(c2.value()));
+  if((isInt(c1, 0) && plain(c2, nodes2)) || (isInt(c2, 0) && plain(c1, nodes1)))
+    return Cell::integer(0);
+  if(isInt(c1, 1) && plain(c2, nodes2))
+    return copy(c2, nodes2, out);
+  if(isInt(c2, 1) && plain(c1, nodes1))
+    return copy(c1, nodes1, out);
+
+  return build(c1, nodes1, c2, nodes2, out, ElementBuilder::multiply);
+}
+
+Cell CellBuilder::copy(Cell c, const CellNodes& nodes, CellNodes& out){
+
+  if(c.kind() != Cell::Kind::Node)
+    return c;
+
+  // Copied before pushing, since nodes may be out
+  std::shared_ptr<const Element> e = nodes[c.index()];
+  out.push_back(std::move(e));
+
+  return Cell::node(std::uint32_t(out.size() - 1));
+}
+
+Cell CellBuilder::adopt(std::shared_ptr<const Element> e, CellNodes& out){
+
+  Cell c{};
+  if(inlined(e.get(), c))
+    return c;
+
+  out.push_back(std::move(e));
+
+  return Cell::node(std::uint32_t(out.size() - 1));
+}
+
+Cell CellBuilder::adopt(std::unique_ptr<Element> e, CellNodes& out){
+
+  // Checked before sharing, so inline elements need no control block
+  Cell c{};
+  if(inlined(e.get(), c))
+    return c;
+
+  return adopt(std::shared_ptr<const Element>{std::move(e)}, out);
+}
@@ -0,0 +1,237 @@
+/**
+  * \file cell.h
+  * \brief Header for Cell, CellStorage and CellBuilder classes
+  */
+#ifndef CELL_H
+#define CELL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "element.h"
+
+/**
+  * \class Cell
+  * \brief Value of one cell of SymbolicSquareMatrix in 8 bytes: an int, a variable, or the index of an
+           expression in the node list of the storage holding the cell. Ints and variables are stored inline,
+           so only expressions need shared Elements
+  */
+class Cell
+{
+public:
+  /**
+    * \brief Kind of value held by cell
+    */
+  enum class Kind : std::uint8_t{ Int, Variable, Node };
+
+  /**
+    * \brief Default constructor for Cell class, holds int 0
+    */
+  Cell() : Cell{Kind::Int, 0}{};
+
+  /**
+    * \brief Creates cell holding int
+    * \param value Int value
+    * \return Cell of kind Int
+    */
+  static Cell integer(int value){
+    return Cell{Kind::Int, std::uint32_t(value)};
+  };
+
+  /**
+    * \brief Creates cell holding variable
+    * \param name Name of variable, A-Z or a-z
+    * \return Cell of kind Variable
+    */
+  static Cell variable(char name){
+    return Cell{Kind::Variable, std::uint32_t(static_cast<unsigned char>(name))};
+  };
+
+  /**
+    * \brief Creates cell referencing expression in node list
+    * \param index Index of expression in node list
+    * \return Cell of kind Node
+    */
+  static Cell node(std::uint32_t index){
+    return Cell{Kind::Node, index};
+  };
+
+  /**
+    * \brief Getter for kind
+    * \return Kind of value held by cell
+    */
+  Kind kind() const{
+    return Kind(bits >> 32);
+  };
+
+  /**
+    * \brief Getter for int value of cell of kind Int
+    * \return Int value
+    */
+  int value() const{
+    return int(std::uint32_t(bits));
+  };
+
+  /**
+    * \brief Getter for variable of cell of kind Variable
+    * \return Name of variable
+    */
+  char name() const{
+    return char(std::uint32_t(bits));
+  };
+
+  /**
+    * \brief Getter for node index of cell of kind Node
+    * \return Index of expression in node list
+    */
+  std::uint32_t index() const{
+    return std::uint32_t(bits);
+  };
+
+  /**
+    * \brief Operator overload for operator ==. Cells of kind Node are equal if they have the same index
+    * \param c Cell to be compared to
+    * \return True if kind and payload are equal, else false
+    */
+  bool operator==(const Cell& c) const{
+    return bits == c.bits;
+  };
+
+private:
+  Cell(Kind k, std::uint32_t payload) : bits{std::uint64_t(k) << 32 | payload}{};
+
+  std::uint64_t bits;
+
+};
+
+static_assert(sizeof(Cell) == 8, "Cell is stored inline in matrices");
+
+/**
+  * \brief Expressions referenced by cells of kind Node, by index
+  */
+using CellNodes = std::vector<std::shared_ptr<const Element>>;
+
+/**
+  * \class CellStorage
+  * \brief Storage of SymbolicSquareMatrix: cells in one contiguous row-major vector, and the expressions
+           their Node cells reference. Node list never holds IntElements or VariableElements, which are
+           always stored inline, so a matrix of ints and variables has an empty node list
+  */
+struct CellStorage
+{
+  std::vector<Cell> cells;
+  CellNodes nodes;
+
+  /**
+    * \brief Returns shared Element equal to cell. Ints are allocated, variables and nodes are shared
+    * \param c Cell of this storage
+    * \return Shared Element holding value of cell
+    */
+  std::shared_ptr<const Element> element(Cell c) const;
+
+  /**
+    * \brief Appends cell to string in the format of Element::toString
+    * \param c Cell of this storage
+    * \param s String to be appended to
+    */
+  void append(Cell c, std::string& s) const;
+
+  /**
+    * \brief Returns hash of cell, equal to the hash of the Element it holds
+    * \param c Cell of this storage
+    * \return Hash of cell
+    */
+  std::size_t hash(Cell c) const;
+
+  /**
+    * \brief Compares cells of two storages structurally
+    * \param c Cell of this storage
+    * \param other Storage of d
+    * \param d Cell to be compared to
+    * \return True if cells hold identical values, else false
+    */
+  bool equal(Cell c, const CellStorage& other, Cell d) const;
+
+  /**
+    * \brief Appends instructions pushing value of cell to bytecode
+    * \param c Cell of this storage
+    * \param code Bytecode to be appended to
+    */
+  void compile(Cell c, Bytecode& code) const;
+
+};
+
+/**
+  * \class CellBuilder
+  * \brief Builds arithmetic on cells like ElementBuilder does on Elements. Ints are folded with wrapping
+           arithmetic and identities with int operands are applied without creating Elements. Other
+           operands are turned into Elements for ElementBuilder, and expressions in results are appended
+           to the output node list. Operand lists may be the output list
+  */
+class CellBuilder
+{
+public:
+  /**
+    * \brief Returns simplified sum of cells
+    * \param c1 First summand
+    * \param nodes1 Node list of c1
+    * \param c2 Second summand
+    * \param nodes2 Node list of c2
+    * \param out Node list of result
+    * \return Cell equal to c1 + c2
+    */
+  static Cell add(Cell c1, const CellNodes& nodes1, Cell c2, const CellNodes& nodes2, CellNodes& out);
+
+  /**
+    * \brief Returns simplified difference of cells
+    * \param c1 Cell subtracted from
+    * \param nodes1 Node list of c1
+    * \param c2 Cell to be subtracted
+    * \param nodes2 Node list of c2
+    * \param out Node list of result
+    * \return Cell equal to c1 - c2
+    */
+  static Cell subtract(Cell c1, const CellNodes& nodes1, Cell c2, const CellNodes& nodes2, CellNodes& out);
+
+  /**
+    * \brief Returns simplified product of cells
+    * \param c1 First factor
+    * \param nodes1 Node list of c1
+    * \param c2 Second factor
+    * \param nodes2 Node list of c2
+    * \param out Node list of result
+    * \return Cell equal to c1 * c2
+    */
+  static Cell multiply(Cell c1, const CellNodes& nodes1, Cell c2, const CellNodes& nodes2, CellNodes& out);
+
+  /**
+    * \brief Copies cell into another node list. Inline cells are returned as they are
+    * \param c Cell to be copied
+    * \param nodes Node list of c
+    * \param out Node list of result
+    * \return Cell referencing the same value in out
+    */
+  static Cell copy(Cell c, const CellNodes& nodes, CellNodes& out);
+
+  /**
+    * \brief Stores Element as cell, inline if it is an IntElement or VariableElement
+    * \param e Shared Element
+    * \param out Node list of result
+    * \return Cell holding e
+    */
+  static Cell adopt(std::shared_ptr<const Element> e, CellNodes& out);
+
+  /**
+    * \brief Stores owned Element as cell. IntElements and VariableElements are stored inline and freed,
+             other elements are shared without copying
+    * \param e Owned Element
+    * \param out Node list of result
+    * \return Cell holding e
+    */
+  static Cell adopt(std::unique_ptr<Element> e, CellNodes& out);
+
+};
+
+#endif // CELL_H
@@ -0,0 +1,42 @@
+/**
+  * \file compiledmatrix.cpp
+  * \brief CompiledSquareMatrix class
+  */
+
+#include "compiledmatrix.h"
+
+CompiledSquareMatrix::CompiledSquareMatrix(const SymbolicSquareMatrix& m) : n{m.n}{
+
+  const CellStorage& cells = m.elements;
+
+  for(std::size_t i = 0; i < cells.cells.size(); i++){
+    cells.compile(cells.cells[i], code);
+    code.store(i);
+  }
+}
+
+ConcreteSquareMatrix CompiledSquareMatrix::evaluate(const Valuation& val) const{
+
+  // Every element is stored by the program, so result is not zeroed first
+  ConcreteSquareMatrix result{n, DenseBuffer::uninitialized(std::size_t(n) * n)};
+
+  code.evaluate(val, result.elements.data());
+
+  return result;
+}
+
+std::vector<ConcreteSquareMatrix> CompiledSquareMatrix::evaluate(const ValuationBatch& batch) const{
+
+  std::vector<ConcreteSquareMatrix> results;
+  std::vector<int*> outputs(batch.size());
+
+  results.reserve(batch.size());
+  for(std::size_t i = 0; i < batch.size(); i++){
+    results.push_back(ConcreteSquareMatrix{n, DenseBuffer::uninitialized(std::size_t(n) * n)});
+    outputs[i] = results[i].elements.data();
+  }
+
+  code.evaluate(batch, outputs.data());
+
+  return results;
+}
@@ -0,0 +1,55 @@
+/**
+  * \file compiledmatrix.h
+  * \brief Header for CompiledSquareMatrix class
+  */
+#ifndef COMPILEDMATRIX_H
+#define COMPILEDMATRIX_H
+
+#include "elementarymatrix.h"
+#include "bytecode.h"
+#include "valuationbatch.h"
+
+/**
+  * \class CompiledSquareMatrix
+  * \brief SymbolicSquareMatrix lowered once into one Bytecode program, for evaluating the same
+           matrix against many valuations without walking Element trees
+  */
+class CompiledSquareMatrix
+{
+public:
+  /**
+    * \brief Constructor for CompiledSquareMatrix class. Compiles every element of param in row-major order
+    * \param m SymbolicSquareMatrix to be compiled
+    */
+  explicit CompiledSquareMatrix(const SymbolicSquareMatrix& m);
+
+  /**
+    * \brief Returns int values of compiled matrix for mapped values
+    * \param val Map containing int values corresponding to char values
+    * \return ConcreteSquareMatrix of evaluated elements. If no mapped value, throws exception
+    */
+  ConcreteSquareMatrix evaluate(const Valuation& val) const;
+
+  /**
+    * \brief Returns int values of compiled matrix for every valuation of batch
+    * \param batch Valuations
+    * \return ConcreteSquareMatrix for every valuation, in order. If a variable is not mapped in every
+               valuation, throws exception
+    */
+  std::vector<ConcreteSquareMatrix> evaluate(const ValuationBatch& batch) const;
+
+  /**
+    * \brief Getter for compiled program
+    * \return Program storing element i * n + j to output i * n + j
+    */
+  const Bytecode& program() const{
+    return code;
+  };
+
+private:
+  unsigned int n;
+  Bytecode code;
+
+};
+
+#endif // COMPILEDMATRIX_H
@@ -3,20 +3,225 @@
   * \brief CompositeElement class
   */
 
+#include <cstdint>
+#include <mutex>
+#include <vector>
 #include "compositeelement.h"
+#include "bytecode.h"
+#include "sumelement.h"
 
-CompositeElement::CompositeElement(const Element& e1, const Element& e2, const std::function<int(int,int)>& op, char opc) : 
-oprnd1{e1.clone()}, oprnd2{e2.clone()}, op_fun{op}, op_ch{opc}{}
+namespace{
 
-CompositeElement::CompositeElement(const CompositeElement& e){
-    
-  oprnd1 = std::unique_ptr<Element>{e.oprnd1->clone()};
-  oprnd2 = std::unique_ptr<Element>{e.oprnd2->clone()};
-  op_fun = e.op_fun;
-  op_ch = e.op_ch;
+  using Opcode = CompositeElement::Opcode;
+
+  /**
+    * \brief Int and variable operands are identical if their values are, composite operands if they are the same object
+    */
+  bool identical(const Element& e1, const Element& e2){
+
+    if(&e1 == &e2)
+      return true;
+    if(auto i = dynamic_cast<const IntElement*>(&e1)){
+      auto j = dynamic_cast<const IntElement*>(&e2);
+      return j != nullptr && i->getVal() == j->getVal();
+    }
+    if(auto v = dynamic_cast<const VariableElement*>(&e1)){
+      auto w = dynamic_cast<const VariableElement*>(&e2);
+      return w != nullptr && v->getVal() == w->getVal();
+    }
+    return false;
+  }
+
+  std::size_t merkleHash(char opc, const Element& e1, const Element& e2){
+    return CompositeElement::combinedHash(opc, e1.hash(), e2.hash());
+  }
+
+  Opcode opcodeOf(char opc){
+
+    switch(opc){
+      case '+':
+        return Opcode::Add;
+      case '-':
+        return Opcode::Subtract;
+      case '*':
+        return Opcode::Multiply;
+      default:
+        return Opcode::Custom;
+    }
+  }
+
+  std::unique_ptr<const std::function<int(int,int)>> customFunction(const std::function<int(int,int)>& op, char opc){
+
+    if(opcodeOf(opc) != Opcode::Custom)
+      return nullptr;
+    return std::unique_ptr<const std::function<int(int,int)>>{new std::function<int(int,int)>{op}};
+  }
+
+  bool sameOperand(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2){
+    return e1 == e2 || *e1 == *e2;
+  }
+
+  /**
+    * \brief Lock for the table. Recursive, as the deleter of a composite that make fails to share runs under it
+    */
+  std::recursive_mutex tableLock;
+
+  /**
+    * \class NodeTable
+    * \brief Open addressing hash-consing table with linear probing. A bucket holds 32 bits of the hash of a
+             composite, which also place it, and its address, nullptr marking an empty bucket. So probing
+             compares nodes only on matching hashes, and growing and erasing, which shifts later buckets
+             back instead of leaving tombstones, touch no nodes
+    */
+  class NodeTable
+  {
+  public:
+    std::size_t size() const{
+      return entries;
+    };
+
+    /**
+      * \brief Finds bucket of composite with hash h for which match(node) is true
+      */
+    template <typename F>
+    const CompositeElement** find(std::size_t h, F&& match){
+
+      if(buckets.empty())
+        return nullptr;
+
+      for(std::size_t i = position(tag(h)); buckets[i].node != nullptr; i = (i + 1) & mask()){
+        if(buckets[i].tag == tag(h) && match(*buckets[i].node))
+          return &buckets[i].node;
+      }
+      return nullptr;
+    };
+
+    void insert(std::size_t h, const CompositeElement* node){
+
+      if(2 * (entries + 1) > buckets.size())
+        grow();
+
+      place(Bucket{tag(h), node});
+      entries++;
+    };
+
+    void erase(std::size_t h, const CompositeElement* node){
+
+      if(buckets.empty())
+        return;
+
+      std::size_t i = position(tag(h));
+      for(; buckets[i].node != node; i = (i + 1) & mask()){
+        if(buckets[i].node == nullptr)
+          return;
+      }
+
+      // Moves back every later bucket of the run that may start at or before the hole
+      for(std::size_t j = (i + 1) & mask(); buckets[j].node != nullptr; j = (j + 1) & mask()){
+        const std::size_t home = position(buckets[j].tag);
+        if(((j - home) & mask()) >= ((j - i) & mask())){
+          buckets[i] = buckets[j];
+          i = j;
+        }
+      }
+
+      buckets[i] = Bucket{0, nullptr};
+      entries--;
+    };
+
+  private:
+    struct Bucket{
+      std::uint32_t tag;
+      const CompositeElement* node;
+    };
+
+    std::size_t mask() const{
+      return buckets.size() - 1;
+    };
+
+    std::size_t position(std::uint32_t t) const{
+      return std::size_t(std::uint64_t(t) * 0x9E3779B97F4A7C15u >> 32) & mask();
+    };
+
+    static std::uint32_t tag(std::size_t h){
+      return std::uint32_t(std::uint64_t(h) >> 32);
+    };
+
+    void place(Bucket b){
+
+      std::size_t i = position(b.tag);
+      while(buckets[i].node != nullptr)
+        i = (i + 1) & mask();
+      buckets[i] = b;
+    };
+
+    void grow(){
+
+      std::vector<Bucket> old(std::max<std::size_t>(64, 2 * buckets.size()), Bucket{0, nullptr});
+      std::swap(old, buckets);
+
+      for(const Bucket& b : old){
+        if(b.node != nullptr)
+          place(b);
+      }
+    };
+
+    std::vector<Bucket> buckets;
+    std::size_t entries = 0;
+
+  };
+
+  NodeTable& table(){
+    // Never destroyed, so composites outliving static destruction can still erase their entries
+    static NodeTable* t = new NodeTable{};
+    return *t;
+  }
+
+  /**
+    * \brief Deleter of hash-consed composites. Entry is erased before the composite is destroyed, so nodes
+             in the table are never being destroyed, and operands are released without holding the lock
+    */
+  struct Release{
+
+    void operator()(CompositeElement* c) const{
+
+      {
+        std::lock_guard<std::recursive_mutex> lock{tableLock};
+        table().erase(c->hash(), c);
+      }
+
+      delete c;
+    };
+
+  };
+
+  int apply(Opcode code, const std::function<int(int,int)>* op, int a, int b){
+
+    // Wraps on overflow like compiled and concrete arithmetic
+    switch(code){
+      case Opcode::Add:
+        return int(std::uint32_t(a) + std::uint32_t(b));
+      case Opcode::Subtract:
+        return int(std::uint32_t(a) - std::uint32_t(b));
+      case Opcode::Multiply:
+        return int(std::uint32_t(a) * std::uint32_t(b));
+      default:
+        return (*op)(a, b);
+    }
+  }
 
 }
 
+CompositeElement::CompositeElement(const Element& e1, const Element& e2, const std::function<int(int,int)>& op, char opc) :
+oprnd1{e1.clone()}, oprnd2{e2.clone()}, op_fun{customFunction(op, opc)}, structuralHash{merkleHash(opc, e1, e2)}, code{opcodeOf(opc)}, op_ch{opc}{}
+
+CompositeElement::CompositeElement(std::shared_ptr<const Element> e1, std::shared_ptr<const Element> e2, const std::function<int(int,int)>& op, char opc) :
+oprnd1{std::move(e1)}, oprnd2{std::move(e2)}, op_fun{customFunction(op, opc)}, structuralHash{merkleHash(opc, *oprnd1, *oprnd2)}, code{opcodeOf(opc)}, op_ch{opc}{}
+
+CompositeElement::CompositeElement(const CompositeElement& e) :
+Element{}, std::enable_shared_from_this<CompositeElement>{}, oprnd1{e.oprnd1}, oprnd2{e.oprnd2},
+op_fun{e.op_fun ? new std::function<int(int,int)>{*e.op_fun} : nullptr}, structuralHash{e.structuralHash}, code{e.code}, op_ch{e.op_ch}{}
+
 CompositeElement& CompositeElement::operator=(const CompositeElement& e){
 
   CompositeElement copy{e};
@@ -25,13 +230,70 @@ CompositeElement& CompositeElement::operator=(const CompositeElement& e){
   oprnd2 = std::move(copy.oprnd2);
   op_fun = std::move(copy.op_fun);
   op_ch = std::move(copy.op_ch);
+  code = copy.code;
+  structuralHash = copy.structuralHash;
 
   return *this;
 }
 
+CompositeElement::~CompositeElement() = default;
+
+std::shared_ptr<const Element> CompositeElement::make(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2,
+                                                      const std::function<int(int,int)>& op, char opc){
+
+  const std::size_t h = merkleHash(opc, *e1, *e2);
+
+  std::lock_guard<std::recursive_mutex> lock{tableLock};
+
+  const CompositeElement** bucket = table().find(h, [&](const CompositeElement& c){
+    return c.op_ch == opc && identical(*c.oprnd1, *e1) && identical(*c.oprnd2, *e2);
+  });
+
+  // Entry of a composite whose deleter has not erased it yet is taken over by the new composite
+  if(bucket != nullptr){
+    if(std::shared_ptr<const Element> existing = (*bucket)->weak_from_this().lock())
+      return existing;
+  }
+
+  // If the control block or the entry cannot be made, the deleter destroys the composite
+  CompositeElement* created = new CompositeElement{e1, e2, op, opc};
+  std::shared_ptr<CompositeElement> shared{created, Release{}};
+
+  if(bucket != nullptr)
+    *bucket = created;
+  else
+    table().insert(h, created);
+
+  return shared;
+}
+
+std::size_t CompositeElement::combinedHash(char opc, std::size_t h1, std::size_t h2){
+
+  return hashCombine(hashCombine(hashCombine(3, std::size_t(opc)), h1), h2);
+}
+
+void CompositeElement::compileOperand(const std::shared_ptr<const Element>& e, Bytecode& code){
+
+  const bool reused = e.use_count() > 1 && (dynamic_cast<const CompositeElement*>(e.get()) != nullptr || dynamic_cast<const SumElement*>(e.get()) != nullptr);
+
+  if(reused && code.load(e.get()))
+    return;
+
+  e->compile(code);
+
+  if(reused)
+    code.save(e.get());
+}
+
+std::size_t CompositeElement::sharedCount(){
+
+  std::lock_guard<std::recursive_mutex> lock{tableLock};
+  return table().size();
+}
+
 Element* CompositeElement::clone() const{
 
-  return new CompositeElement{*oprnd1, *oprnd2, op_fun, op_ch};
+  return new CompositeElement{*this};
 
 }
 
@@ -45,6 +307,28 @@ std::string CompositeElement::toString()const{
 
 int CompositeElement::evaluate(const Valuation& v) const{
 
-  return op_fun(oprnd1->evaluate(v), oprnd2->evaluate(v));
+  return apply(code, op_fun.get(), oprnd1->evaluate(v), oprnd2->evaluate(v));
+
+}
 
-}
\ No newline at end of file
+bool CompositeElement::equals(const Element& e) const{
+
+  const CompositeElement* c = dynamic_cast<const CompositeElement*>(&e);
+
+  // N-ary sums compare themselves to chains of sums
+  if(c == nullptr)
+    return dynamic_cast<const SumElement*>(&e) != nullptr && e.equals(*this);
+
+  if(c->op_ch != op_ch || c->structuralHash != structuralHash)
+    return false;
+
+  return sameOperand(oprnd1, c->oprnd1) && sameOperand(oprnd2, c->oprnd2);
+}
+
+void CompositeElement::compile(Bytecode& code) const{
+
+  compileOperand(oprnd1, code);
+  compileOperand(oprnd2, code);
+  code.pushOperation(op_ch);
+
+}
@@ -5,25 +5,49 @@
 #ifndef COMPOSITEELEMENT_H
 #define COMPOSITEELEMENT_H
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include "element.h"
 
 /**
   * \class CompositeElement
-  * \brief Class encapsulating composites of two Element objects and arithmetic function between them
+  * \brief Class encapsulating composites of two Element objects and arithmetic function between them.
+           Operands are immutable and shared, so copies and clones reference the same operands and
+           expressions form a DAG instead of a tree. Composites created by make are found again through
+           an open addressing table of their addresses and 32 bits of their hashes.
   */
-class CompositeElement : public Element
+class CompositeElement : public Element, public std::enable_shared_from_this<CompositeElement>
 {
 public:
+  /**
+    * \brief Operation of composite. Custom operations keep their function, the others are applied directly
+    */
+  enum class Opcode : std::uint8_t{
+    Add,
+    Subtract,
+    Multiply,
+    Custom
+  };
+
   /**
     * \brief Constructor for CompositeElement class
     * \param e1 First element object to be stored
     * \param e2 Second element object to be stored
-    * \param op Function for arithmetic operation to be applied to parameters
+    * \param op Function for arithmetic operation to be applied to parameters, kept only if symbol is not '+', '-' or '*'
     * \param opc Symbol for arithmetic operation
     */
   CompositeElement(const Element& e1, const Element& e2, const std::function<int(int,int)>& op, char opc);
 
+  /**
+    * \brief Constructor for CompositeElement class referencing operands instead of copying them
+    * \param e1 First element object to be referenced
+    * \param e2 Second element object to be referenced
+    * \param op Function for arithmetic operation to be applied to parameters
+    * \param opc Symbol for arithmetic operation
+    */
+  CompositeElement(std::shared_ptr<const Element> e1, std::shared_ptr<const Element> e2, const std::function<int(int,int)>& op, char opc);
+
   /**
     * \brief Copy constructor for CompositeElement class
     * \param e CompositeElement to be copied
@@ -38,12 +62,83 @@ public:
   CompositeElement& operator=(const CompositeElement& e);
 
   /**
-    * \brief Virtual destructor for CompositeElement class
+    * \brief Virtual destructor for CompositeElement class. Hash-consed elements are removed from table
+             before they are destroyed
+    */
+  virtual ~CompositeElement();
+
+  /**
+    * \brief Returns hash-consed composite of operands. While a composite of the same operation on
+             identical operands exists, returns it instead of creating a new one. Int and variable
+             operands are identical if their values are, composite operands if they are the same object.
+             Operation is identified by its symbol.
+    * \param e1 First element object to be referenced
+    * \param e2 Second element object to be referenced
+    * \param op Function for arithmetic operation to be applied to parameters
+    * \param opc Symbol for arithmetic operation
+    * \return Shared composite element
+    */
+  static std::shared_ptr<const Element> make(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2,
+                                             const std::function<int(int,int)>& op, char opc);
+
+  /**
+    * \brief Getter for first operand
+    * \return Shared pointer to first operand
+    */
+  const std::shared_ptr<const Element>& first() const{
+    return oprnd1;
+  };
+
+  /**
+    * \brief Getter for second operand
+    * \return Shared pointer to second operand
+    */
+  const std::shared_ptr<const Element>& second() const{
+    return oprnd2;
+  };
+
+  /**
+    * \brief Getter for operation symbol
+    * \return Symbol for arithmetic operation
     */
-  virtual ~CompositeElement() = default;
+  char operation() const{
+    return op_ch;
+  };
 
   /**
-    * \brief Creates a clone of self and returns pointer to it
+    * \brief Getter for operation
+    * \return Opcode of operation
+    */
+  Opcode opcode() const{
+    return code;
+  };
+
+  /**
+    * \brief Returns Merkle hash of composite of elements with hashes h1 and h2, so that elements with the
+             same string as a composite, such as n-ary sums, can hash equally
+    * \param opc Symbol for arithmetic operation
+    * \param h1 Hash of first operand
+    * \param h2 Hash of second operand
+    * \return Hash of composite
+    */
+  static std::size_t combinedHash(char opc, std::size_t h1, std::size_t h2);
+
+  /**
+    * \brief Appends instructions for operand to bytecode. Composites and sums shared with other
+             expressions are computed once and reused
+    * \param e Operand
+    * \param code Bytecode to be appended to
+    */
+  static void compileOperand(const std::shared_ptr<const Element>& e, Bytecode& code);
+
+  /**
+    * \brief Getter for number of hash-consed composite elements alive
+    * \return Number of elements created by make that are still referenced
+    */
+  static std::size_t sharedCount();
+
+  /**
+    * \brief Creates a clone of self and returns pointer to it. Clone shares operands with self
     * \return Pointer to clone of self
     */
   Element* clone() const override;
@@ -61,12 +156,39 @@ public:
     */
   int evaluate(const Valuation& v) const override;
 
+  /**
+    * \brief Appends instructions for both operands followed by arithmetic operation to bytecode.
+             Operands shared with other composites are computed once and reused.
+             Throws exception if operation symbol is not '+', '-' or '*'
+    * \param code Bytecode to be appended to
+    */
+  void compile(Bytecode& code) const override;
+
+  /**
+    * \brief Returns Merkle hash of composite, combining operation symbol with hashes of operands.
+             Computed once at construction, so hashing never visits operands
+    * \return Hash of composite
+    */
+  std::size_t hash() const override{
+    return structuralHash;
+  };
+
+  /**
+    * \brief Compares structure of composites. Shared operands are equal without visiting them,
+             and operands with different hashes differ without visiting them
+    * \param e Element to be compared to self
+    * \return True if e is composite with same operation and equal operands, else false
+    */
+  bool equals(const Element& e) const override;
+
 private:
-  std::unique_ptr<Element> oprnd1;
-  std::unique_ptr<Element> oprnd2;
-  std::function<int(int,int)> op_fun;
+  std::shared_ptr<const Element> oprnd1;
+  std::shared_ptr<const Element> oprnd2;
+  std::unique_ptr<const std::function<int(int,int)>> op_fun;
+  std::size_t structuralHash;
+  Opcode code;
   char op_ch;
 
 };
 
-#endif // COMPOSITEELEMENT_H
\ No newline at end of file
+#endif // COMPOSITEELEMENT_H
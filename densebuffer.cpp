@@ -0,0 +1,106 @@
+/**
+  * \file densebuffer.cpp
+  * \brief DenseBuffer class
+  */
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <sys/mman.h>
+#include "densebuffer.h"
+
+namespace{
+
+  // aligned_alloc requires the size to be a multiple of the alignment
+  int* allocate(std::size_t count){
+
+    if(count == 0)
+      return nullptr;
+
+    std::size_t bytes = count * sizeof(int);
+    bytes = (bytes + DenseBuffer::alignment - 1) / DenseBuffer::alignment * DenseBuffer::alignment;
+
+    void* ptr = std::aligned_alloc(DenseBuffer::alignment, bytes);
+    if(ptr == nullptr)
+      throw std::bad_alloc{};
+
+    return static_cast<int*>(ptr);
+  }
+
+}
+
+DenseBuffer::DenseBuffer(std::size_t count) : vals{allocate(count)}, count{count}, mapping{nullptr}, mappingBytes{0}{
+
+  if(count != 0)
+    std::memset(vals, 0, count * sizeof(int));
+}
+
+DenseBuffer DenseBuffer::uninitialized(std::size_t count){
+
+  DenseBuffer b{};
+  b.vals = allocate(count);
+  b.count = count;
+
+  return b;
+}
+
+DenseBuffer DenseBuffer::adoptMapping(void* mapping, std::size_t bytes, std::size_t offset, std::size_t count){
+
+  DenseBuffer b{};
+  b.mapping = mapping;
+  b.mappingBytes = bytes;
+  b.vals = count == 0 ? nullptr : reinterpret_cast<int*>(static_cast<char*>(mapping) + offset);
+  b.count = count;
+
+  return b;
+}
+
+// Copies always get their own allocation
+DenseBuffer::DenseBuffer(const DenseBuffer& b) : vals{allocate(b.count)}, count{b.count}, mapping{nullptr}, mappingBytes{0}{
+
+  if(count != 0)
+    std::memcpy(vals, b.vals, count * sizeof(int));
+}
+
+DenseBuffer::DenseBuffer(DenseBuffer&& b) noexcept : vals{b.vals}, count{b.count}, mapping{b.mapping}, mappingBytes{b.mappingBytes}{
+
+  b.vals = nullptr;
+  b.count = 0;
+  b.mapping = nullptr;
+  b.mappingBytes = 0;
+}
+
+DenseBuffer::~DenseBuffer(){
+
+  if(mapping != nullptr)
+    munmap(mapping, mappingBytes);
+  else
+    std::free(vals);
+}
+
+DenseBuffer& DenseBuffer::operator=(const DenseBuffer& b){
+
+  if(this == &b)
+    return *this;
+
+  // Reusing the allocation when sizes match
+  if(count != b.count){
+    *this = DenseBuffer{b};
+  }
+  else if(count != 0){
+    std::memcpy(vals, b.vals, count * sizeof(int));
+  }
+
+  return *this;
+}
+
+DenseBuffer& DenseBuffer::operator=(DenseBuffer&& b) noexcept{
+
+  std::swap(vals, b.vals);
+  std::swap(count, b.count);
+  std::swap(mapping, b.mapping);
+  std::swap(mappingBytes, b.mappingBytes);
+
+  return *this;
+}
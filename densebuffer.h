@@ -0,0 +1,172 @@
+/**
+  * \file densebuffer.h
+  * \brief Header for DenseBuffer class
+  */
+#ifndef DENSEBUFFER_H
+#define DENSEBUFFER_H
+
+#include <cstddef>
+
+/**
+  * \class DenseBuffer
+  * \brief Flat, cache line aligned buffer of ints. Used as row-major storage for ConcreteSquareMatrix
+  */
+class DenseBuffer
+{
+public:
+  /**
+    * \brief Alignment of the first value in bytes
+    */
+  static constexpr std::size_t alignment = 64;
+
+  /**
+    * \brief Default constructor for DenseBuffer class. Creates empty buffer without allocating
+    */
+  DenseBuffer() : vals{nullptr}, count{0}, mapping{nullptr}, mappingBytes{0}{};
+
+  /**
+    * \brief Constructor for DenseBuffer class. Allocates count values set to zero
+    * \param count Number of ints in buffer
+    */
+  explicit DenseBuffer(std::size_t count);
+
+  /**
+    * \brief Allocates count values without initializing them. For results that are fully overwritten
+    * \param count Number of ints in buffer
+    * \return DenseBuffer with indeterminate values
+    */
+  static DenseBuffer uninitialized(std::size_t count);
+
+  /**
+    * \brief Takes ownership of a memory mapping, which is unmapped when the buffer is destroyed. Values
+             are used in place, so the mapping must be writable, and private if the file must not change
+    * \param mapping Start of mapping created with mmap
+    * \param bytes Length of mapping
+    * \param offset Byte offset of first value in mapping, a multiple of alignment
+    * \param count Number of ints in buffer
+    * \return DenseBuffer using the mapped values
+    */
+  static DenseBuffer adoptMapping(void* mapping, std::size_t bytes, std::size_t offset, std::size_t count);
+
+  /**
+    * \brief Copy constructor for DenseBuffer class
+    * \param b DenseBuffer to be copied
+    */
+  DenseBuffer(const DenseBuffer& b);
+
+  /**
+    * \brief Move constructor for DenseBuffer class. Leaves param empty
+    * \param b DenseBuffer to be moved
+    */
+  DenseBuffer(DenseBuffer&& b) noexcept;
+
+  /**
+    * \brief Destructor for DenseBuffer class, frees or unmaps values
+    */
+  ~DenseBuffer();
+
+  /**
+    * \brief Copies the contents of param to self
+    * \param b DenseBuffer to be copied
+    * \return Self
+    */
+  DenseBuffer& operator=(const DenseBuffer& b);
+
+  /**
+    * \brief Moves the contents of param to self
+    * \param b DenseBuffer to be moved
+    * \return Self
+    */
+  DenseBuffer& operator=(DenseBuffer&& b) noexcept;
+
+  /**
+    * \brief Getter for number of values
+    * \return Number of ints in buffer
+    */
+  std::size_t size() const{
+    return count;
+  };
+
+  /**
+    * \brief Checks whether values live in a memory mapping
+    * \return True if buffer was created with adoptMapping, else false
+    */
+  bool isMapped() const{
+    return mapping != nullptr;
+  };
+
+  /**
+    * \brief Getter for raw values
+    * \return Pointer to first value, nullptr if empty
+    */
+  int* data(){
+    return vals;
+  };
+
+  /**
+    * \brief Getter for raw values
+    * \return Pointer to first value, nullptr if empty
+    */
+  const int* data() const{
+    return vals;
+  };
+
+  /**
+    * \brief Operator overload for operator [] for DenseBuffer class
+    * \param i Index of value
+    * \return Reference to value
+    */
+  int& operator[](std::size_t i){
+    return vals[i];
+  };
+
+  /**
+    * \brief Operator overload for operator [] for DenseBuffer class
+    * \param i Index of value
+    * \return Reference to value
+    */
+  const int& operator[](std::size_t i) const{
+    return vals[i];
+  };
+
+  /**
+    * \brief Returns iterator to first value, for range-based loops and algorithms
+    * \return Pointer to first value
+    */
+  int* begin(){
+    return vals;
+  };
+
+  /**
+    * \brief Returns iterator past last value
+    * \return Pointer past last value
+    */
+  int* end(){
+    return vals + count;
+  };
+
+  /**
+    * \brief Returns iterator to first value, for range-based loops and algorithms
+    * \return Pointer to first value
+    */
+  const int* begin() const{
+    return vals;
+  };
+
+  /**
+    * \brief Returns iterator past last value
+    * \return Pointer past last value
+    */
+  const int* end() const{
+    return vals + count;
+  };
+
+private:
+  int* vals;
+  std::size_t count;
+  void* mapping;  // nullptr if vals was allocated
+  std::size_t mappingBytes;
+
+};
+
+#endif // DENSEBUFFER_H
@@ -0,0 +1,395 @@
+/**
+  * \file dotproductelement.cpp
+  * \brief DotProductElement class
+  */
+
+#include <algorithm>
+#include "dotproductelement.h"
+#include "compositeelement.h"
+#include "elementbuilder.h"
+#include "bytecode.h"
+
+namespace{
+
+  // Cells gathered before one vectorized multiply loop
+  constexpr std::size_t block = 64;
+
+  bool isInt(Cell c, int value){
+    return c.kind() == Cell::Kind::Int && c.value() == value;
+  }
+
+  std::uint32_t cellValue(Cell c, const CellStorage& s, const Valuation& v){
+
+    switch(c.kind()){
+      case Cell::Kind::Int:
+        return std::uint32_t(c.value());
+      case Cell::Kind::Variable:
+        return std::uint32_t(v.at(c.name()));
+      default:
+        return std::uint32_t(s.nodes[c.index()]->evaluate(v));
+    }
+  }
+
+  void compileCell(Cell c, const CellStorage& s, Bytecode& code){
+
+    switch(c.kind()){
+      case Cell::Kind::Int:
+        code.pushConstant(c.value());
+        break;
+      case Cell::Kind::Variable:
+        code.pushVariable(c.name());
+        break;
+      default:
+        CompositeElement::compileOperand(s.nodes[c.index()], code);
+    }
+  }
+
+  PolynomialElement cellPolynomial(Cell c, const CellStorage& s, PolynomialElement::Cache& cache){
+
+    switch(c.kind()){
+      case Cell::Kind::Int:
+        return PolynomialElement{c.value()};
+      case Cell::Kind::Variable:
+        return PolynomialElement{c.name()};
+      default:
+        return PolynomialElement::of(*s.nodes[c.index()], cache);
+    }
+  }
+
+}
+
+/**
+  * \brief Term a * b of dot product as CellBuilder::multiply simplifies it: a folded int, a factor kept
+           by a factor of one, or a product
+  */
+struct DotProductElement::Term
+{
+  enum class Kind : std::uint8_t{ Int, Copy, Product };
+
+  explicit Term(int v) : kind{Kind::Int}, value{v}{};
+
+  Term(Cell x, Cell y) : a{x}, b{y}{
+
+    if(x.kind() == Cell::Kind::Int && y.kind() == Cell::Kind::Int){
+      kind = Kind::Int;
+      value = int(std::uint32_t(x.value()) * std::uint32_t(y.value()));
+    }
+    else if(isInt(x, 0) || isInt(y, 0)){
+      kind = Kind::Int;
+    }
+    else if(isInt(x, 1)){
+      kind = Kind::Copy;
+      a = y;
+      fromRight = true;
+    }
+    else if(isInt(y, 1)){
+      kind = Kind::Copy;
+    }
+  };
+
+  const CellStorage& copied(const CellStorage& l, const CellStorage& r) const{
+    return fromRight ? r : l;
+  };
+
+  std::size_t hash(const CellStorage& l, const CellStorage& r) const{
+
+    switch(kind){
+      case Kind::Int:
+        return hashCombine(1, std::size_t(unsigned(value)));
+      case Kind::Copy:
+        return copied(l, r).hash(a);
+      default:
+        return CompositeElement::combinedHash('*', l.hash(a), r.hash(b));
+    }
+  };
+
+  Kind kind = Kind::Product;
+  int value = 0;
+  Cell a{};
+  Cell b{};
+  bool fromRight = false;
+};
+
+DotProductElement::Operands::Operands(const CellStorage& l, const CellStorage& r, std::size_t length) : left{l}, right{r}, n{length}{
+
+  // Polynomials stay polynomials and differences may cancel against the sum, so CellBuilder simplifies
+  // terms of them further than dot products do
+  auto classify = [](const CellNodes& nodes){
+    std::vector<Node> kinds;
+    kinds.reserve(nodes.size());
+    for(const auto& e : nodes){
+      const CompositeElement* d = dynamic_cast<const CompositeElement*>(e.get());
+      if(dynamic_cast<const PolynomialElement*>(e.get()) != nullptr)
+        kinds.push_back(Node::Polynomial);
+      else if(d != nullptr && d->operation() == '-')
+        kinds.push_back(Node::Difference);
+      else
+        kinds.push_back(Node::Plain);
+    }
+    return kinds;
+  };
+
+  leftNodes = classify(l.nodes);
+  rightNodes = &r == &l ? leftNodes : classify(r.nodes);
+}
+
+const std::shared_ptr<const CellStorage>& DotProductElement::Operands::leftShared(){
+
+  if(!leftCopy)
+    leftCopy = std::make_shared<const CellStorage>(left);
+  return leftCopy;
+}
+
+const std::shared_ptr<const CellStorage>& DotProductElement::Operands::rightShared(){
+
+  if(&right == &left)
+    return leftShared();
+  if(!rightCopy)
+    rightCopy = std::make_shared<const CellStorage>(right);
+  return rightCopy;
+}
+
+DotProductElement::DotProductElement(std::shared_ptr<const CellStorage> l, std::shared_ptr<const CellStorage> r, std::size_t i, std::size_t j,
+                                     std::size_t length, std::size_t firstSymbolic, int leading, std::size_t terms, std::size_t hash) :
+SumElement{hash}, left{std::move(l)}, right{std::move(r)}, row{std::uint32_t(i)}, column{std::uint32_t(j)}, n{std::uint32_t(length)},
+first{std::uint32_t(firstSymbolic)}, items{std::uint32_t(terms)}, prefix{leading}{}
+
+template <typename F>
+void DotProductElement::forEachTerm(const CellStorage& l, const CellStorage& r, std::size_t i, std::size_t j, std::size_t length,
+                                    std::size_t firstSymbolic, int leading, F&& f){
+
+  // Ints before the first other term are folded into one, after it only zeroes vanish
+  if(leading != 0)
+    f(Term{leading});
+
+  for(std::size_t k = firstSymbolic; k < length; k++){
+    const Term t{l.cells[i * length + k], r.cells[k * length + j]};
+    if(k != firstSymbolic && t.kind == Term::Kind::Int && t.value == 0)
+      continue;
+    f(t);
+  }
+}
+
+template <typename F>
+void DotProductElement::forEachTerm(F&& f) const{
+
+  forEachTerm(*left, *right, row, column, n, first, prefix, f);
+}
+
+bool DotProductElement::make(Operands& operands, std::size_t row, std::size_t column, CellNodes& out, Cell& result){
+
+  const CellStorage& l = operands.left;
+  const CellStorage& r = operands.right;
+  const std::size_t n = operands.n;
+
+  std::uint32_t leading = 0;
+  std::size_t firstSymbolic = n;
+
+  auto node = [](Cell c, const std::vector<Operands::Node>& kinds){
+    return c.kind() == Cell::Kind::Node ? kinds[c.index()] : Operands::Node::Plain;
+  };
+
+  for(std::size_t k = 0; k < n; k++){
+    const Cell a = l.cells[row * n + k];
+    const Cell b = r.cells[k * n + column];
+    const Term t{a, b};
+    if(node(a, operands.leftNodes) == Operands::Node::Polynomial || node(b, operands.rightNodes) == Operands::Node::Polynomial)
+      return false;
+    if(t.kind == Term::Kind::Copy && node(t.a, t.fromRight ? operands.rightNodes : operands.leftNodes) == Operands::Node::Difference)
+      return false;
+    if(firstSymbolic == n){
+      if(t.kind == Term::Kind::Int)
+        leading += std::uint32_t(t.value);
+      else
+        firstSymbolic = k;
+    }
+  }
+
+  if(firstSymbolic == n){
+    result = Cell::integer(int(leading));
+    return true;
+  }
+
+  std::size_t terms = 0;
+  std::size_t h = 0;
+  forEachTerm(l, r, row, column, n, firstSymbolic, int(leading), [&](const Term& t){
+    const std::size_t th = t.hash(l, r);
+    h = terms == 0 ? th : extendHash(h, th);
+    terms++;
+  });
+
+  // A single term is the term itself, as the chain would be
+  if(terms == 1){
+    const Term t{l.cells[row * n + firstSymbolic], r.cells[firstSymbolic * n + column]};
+    result = t.kind == Term::Kind::Copy ? CellBuilder::copy(t.a, t.copied(l, r).nodes, out) : CellBuilder::multiply(t.a, l.nodes, t.b, r.nodes, out);
+    return true;
+  }
+
+  out.push_back(std::shared_ptr<const Element>{new DotProductElement{operands.leftShared(), operands.rightShared(), row, column, n, firstSymbolic, int(leading), terms, h}});
+  result = Cell::node(std::uint32_t(out.size() - 1));
+
+  return true;
+}
+
+std::vector<std::shared_ptr<const Element>> DotProductElement::terms() const{
+
+  std::vector<std::shared_ptr<const Element>> t;
+  t.reserve(items);
+
+  forEachTerm([&](const Term& term){
+    switch(term.kind){
+      case Term::Kind::Int:
+        t.push_back(ElementBuilder::constant(term.value));
+        break;
+      case Term::Kind::Copy:
+        t.push_back(term.copied(*left, *right).element(term.a));
+        break;
+      default:
+        t.push_back(CompositeElement::make(left->element(term.a), right->element(term.b), std::multiplies<int>{}, '*'));
+    }
+  });
+
+  return t;
+}
+
+PolynomialElement DotProductElement::polynomial(PolynomialElement::Cache& cache) const{
+
+  PolynomialElement p{};
+
+  forEachTerm([&](const Term& term){
+    switch(term.kind){
+      case Term::Kind::Int:
+        p = p + PolynomialElement{term.value};
+        break;
+      case Term::Kind::Copy:
+        p = p + cellPolynomial(term.a, term.copied(*left, *right), cache);
+        break;
+      default:
+        p = p + cellPolynomial(term.a, *left, cache) * cellPolynomial(term.b, *right, cache);
+    }
+  });
+
+  return p;
+}
+
+Element* DotProductElement::clone() const{
+
+  return new DotProductElement{*this};
+}
+
+void DotProductElement::append(const Term& t, std::string& s) const{
+
+  switch(t.kind){
+    case Term::Kind::Int:
+      s += std::to_string(t.value);
+      break;
+    case Term::Kind::Copy:
+      t.copied(*left, *right).append(t.a, s);
+      break;
+    default:
+      s += '(';
+      left->append(t.a, s);
+      s += '*';
+      right->append(t.b, s);
+      s += ')';
+  }
+}
+
+std::string DotProductElement::toString() const{
+
+  std::string s(items - 1, '(');
+  bool firstTerm = true;
+
+  forEachTerm([&](const Term& t){
+    if(!firstTerm)
+      s += '+';
+    append(t, s);
+    if(!firstTerm)
+      s += ')';
+    firstTerm = false;
+  });
+
+  return s;
+}
+
+int DotProductElement::evaluate(const Valuation& v) const{
+
+  std::uint32_t x[block];
+  std::uint32_t y[block];
+  std::uint32_t sum = 0;
+
+  for(std::size_t base = 0; base < n; base += block){
+    const std::size_t width = std::min(block, std::size_t(n) - base);
+    for(std::size_t k = 0; k < width; k++){
+      const Cell a = left->cells[std::size_t(row) * n + base + k];
+      const Cell b = right->cells[(base + k) * n + column];
+      const bool zero = isInt(a, 0) || isInt(b, 0);
+      x[k] = zero ? 0 : cellValue(a, *left, v);
+      y[k] = zero ? 0 : cellValue(b, *right, v);
+    }
+    for(std::size_t k = 0; k < width; k++){
+      sum += x[k] * y[k];
+    }
+  }
+
+  return int(sum);
+}
+
+void DotProductElement::compile(Bytecode& code) const{
+
+  std::uint32_t constant = 0;
+  forEachTerm([&](const Term& t){
+    if(t.kind == Term::Kind::Int)
+      constant += std::uint32_t(t.value);
+  });
+
+  code.pushConstant(int(constant));
+
+  forEachTerm([&](const Term& t){
+    if(t.kind == Term::Kind::Copy){
+      compileCell(t.a, t.copied(*left, *right), code);
+      code.pushOperation('+');
+    }
+    else if(t.kind == Term::Kind::Product){
+      compileCell(t.a, *left, code);
+      compileCell(t.b, *right, code);
+      code.pushMultiplyAdd();
+    }
+  });
+}
+
+std::vector<SumElement::TermView> DotProductElement::views() const{
+
+  std::vector<TermView> t;
+  t.reserve(items);
+
+  forEachTerm([&](const Term& term){
+    TermView view{TermView::Kind::Product, nullptr, left.get(), right.get(), term.a, term.b};
+    if(term.kind == Term::Kind::Int){
+      view.kind = TermView::Kind::Int;
+      view.a = Cell::integer(term.value);
+    }
+    else if(term.kind == Term::Kind::Copy){
+      const CellStorage& s = term.copied(*left, *right);
+      view.left = &s;
+      if(term.a.kind() == Cell::Kind::Node){
+        view.kind = TermView::Kind::Element;
+        view.element = s.nodes[term.a.index()].get();
+      }
+      else
+        view.kind = term.a.kind() == Cell::Kind::Variable ? TermView::Kind::Variable : TermView::Kind::Int;
+    }
+    t.push_back(view);
+  });
+
+  return t;
+}
+
+bool DotProductElement::equals(const Element& e) const{
+
+  const DotProductElement* d = dynamic_cast<const DotProductElement*>(&e);
+  if(d != nullptr && d->left == left && d->right == right && d->row == row && d->column == column)
+    return true;
+
+  return SumElement::equals(e);
+}
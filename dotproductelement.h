@@ -0,0 +1,163 @@
+/**
+  * \file dotproductelement.h
+  * \brief Header for DotProductElement class
+  */
+#ifndef DOTPRODUCTELEMENT_H
+#define DOTPRODUCTELEMENT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "cell.h"
+#include "sumelement.h"
+
+/**
+  * \class DotProductElement
+  * \brief Cell of a product of SymbolicSquareMatrices: the dot product of row i of the left operand and column j
+           of the right one. It references the cells of both operands instead of building a composite for every
+           term, so a product cell is one node. Terms are simplified like the chain CellBuilder would build:
+           products of ints are folded, leading ints are summed, zero terms vanish and factors of one are dropped,
+           and the string, hash and equality are those of that chain
+  */
+class DotProductElement : public SumElement
+{
+public:
+  /**
+    * \class Operands
+    * \brief Operands of one matrix product. Their nodes are classified once, and cells of an operand are
+             copied into shared storage once, when the first dot product referencing them is made
+    */
+  class Operands
+  {
+  public:
+    /**
+      * \brief Constructor for Operands class
+      * \param l Cells of left operand
+      * \param r Cells of right operand, may be l
+      * \param length Size of operands
+      */
+    Operands(const CellStorage& l, const CellStorage& r, std::size_t length);
+
+  private:
+    enum class Node : std::uint8_t{ Plain, Polynomial, Difference };
+
+    const std::shared_ptr<const CellStorage>& leftShared();
+    const std::shared_ptr<const CellStorage>& rightShared();
+
+    const CellStorage& left;
+    const CellStorage& right;
+    std::size_t n;
+    std::vector<Node> leftNodes;
+    std::vector<Node> rightNodes;
+    std::shared_ptr<const CellStorage> leftCopy;
+    std::shared_ptr<const CellStorage> rightCopy;
+
+    friend class DotProductElement;
+
+  };
+
+  /**
+    * \brief Computes cell in row and column of product. Ints, single terms and dot products are stored in
+             result, the expressions they need in out. Polynomial operands and terms that are differences
+             kept by a factor of one are left to CellBuilder, since they simplify further
+    * \param operands Operands of product
+    * \param row Row of left operand
+    * \param column Column of right operand
+    * \param out Node list of result
+    * \param result Cell of product
+    * \return True if result was computed, false if the cell needs CellBuilder
+    */
+  static bool make(Operands& operands, std::size_t row, std::size_t column, CellNodes& out, Cell& result);
+
+  /**
+    * \brief Getter for number of terms, after ints are folded and zero terms vanish
+    * \return Number of terms, at least two
+    */
+  std::size_t count() const override{
+    return items;
+  };
+
+  /**
+    * \brief Returns terms as shared elements. Products of cells are made as hash-consed composites
+    * \return Terms in order of summation
+    */
+  std::vector<std::shared_ptr<const Element>> terms() const override;
+
+  /**
+    * \brief Expands dot product into polynomial straight from the cells of its operands, without building
+             composites for its terms. Expansions of nodes are reused from and added to cache
+    * \param cache Expansions of elements converted earlier
+    * \return Polynomial equal to dot product
+    */
+  PolynomialElement polynomial(PolynomialElement::Cache& cache) const override;
+
+  /**
+    * \brief Creates a clone of self and returns pointer to it. Clone references the same operands
+    * \return Pointer to clone of self
+    */
+  Element* clone() const override;
+
+  /**
+    * \brief Returns the string of the chain of composites CellBuilder would build: leading ints folded into
+             one, zero terms left out, factors of one dropped and other terms as (a*b)
+    * \return Dot product in string form
+    */
+  std::string toString() const override;
+
+  /**
+    * \brief Computes dot product. Values of each block of cells are gathered first and multiplied in one
+             loop the compiler vectorizes. Cells multiplied by zero are not evaluated
+    * \param v Map for char variables and int values
+    * \return Int value of dot product, wrapping on overflow
+    */
+  int evaluate(const Valuation& v) const override;
+
+  /**
+    * \brief Appends the sum of int terms as one constant, and a multiply-add for every other term
+    * \param code Bytecode to be appended to
+    */
+  void compile(Bytecode& code) const override;
+
+  /**
+    * \brief Dot products of the same row and column of the same operands are equal without visiting terms,
+             others are compared term by term on the cells of the operands
+    * \param e Element to be compared to self
+    * \return True if e has the same string as self, else false
+    */
+  bool equals(const Element& e) const override;
+
+protected:
+  /**
+    * \brief Returns terms as views of the cells of both operands
+    * \return Views of terms in order of summation
+    */
+  std::vector<TermView> views() const override;
+
+private:
+  struct Term;
+
+  DotProductElement(std::shared_ptr<const CellStorage> l, std::shared_ptr<const CellStorage> r, std::size_t i, std::size_t j,
+                    std::size_t length, std::size_t firstSymbolic, int leading, std::size_t terms, std::size_t hash);
+
+  template <typename F>
+  static void forEachTerm(const CellStorage& l, const CellStorage& r, std::size_t i, std::size_t j, std::size_t length,
+                          std::size_t firstSymbolic, int leading, F&& f);
+
+  template <typename F>
+  void forEachTerm(F&& f) const;
+
+  void append(const Term& t, std::string& s) const;
+
+  std::shared_ptr<const CellStorage> left;
+  std::shared_ptr<const CellStorage> right;
+  std::uint32_t row;
+  std::uint32_t column;
+  std::uint32_t n;
+  std::uint32_t first;
+  std::uint32_t items;
+  int prefix;
+
+};
+
+#endif // DOTPRODUCTELEMENT_H
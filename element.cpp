@@ -4,6 +4,7 @@
   */
 
 #include "element.h"
+#include "bytecode.h"
 
 template<>
 TElement<int>::TElement(int v) : val{v}{}
@@ -45,6 +46,26 @@ int TElement<char>::evaluate(const Valuation& v) const{
   return v.at(val);
 }
 
+template<>
+void TElement<int>::compile(Bytecode& code) const{
+  code.pushConstant(val);
+}
+
+template<>
+void TElement<char>::compile(Bytecode& code) const{
+  code.pushVariable(val);
+}
+
+template<>
+std::size_t TElement<int>::hash() const{
+  return hashCombine(1, std::size_t(unsigned(val)));
+}
+
+template<>
+std::size_t TElement<char>::hash() const{
+  return hashCombine(2, std::size_t(val));
+}
+
 template<>
 TElement<int>& TElement<int>::operator+=(const TElement<int>& i){
   val = val + i.val;
@@ -86,8 +107,9 @@ std::ostream& operator<<(std::ostream& os, const Element& i){
 }
 
 bool operator==(const Element& e1, const Element& e2){
-  if(e1.toString() == e2.toString())
+  if(&e1 == &e2)
     return true;
-  else
+  if(e1.hash() != e2.hash())
     return false;
+  return e1.equals(e2);
 }
\ No newline at end of file
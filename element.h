@@ -5,11 +5,26 @@
 #ifndef ELEMENT_H
 #define ELEMENT_H
 
+#include <cstddef>
+#include <cstdint>
 #include <sstream>
 #include <stdexcept>
 #include <memory>
 #include "valuation.h"
 
+class Bytecode;
+
+/**
+  * \brief Mixes value into hash. Order matters, so hashes of sequences differ from hashes of their permutations
+  * \param seed Hash so far
+  * \param value Value to be mixed in
+  * \return Combined hash
+  */
+inline std::size_t hashCombine(std::size_t seed, std::size_t value){
+  std::uint64_t h = (std::uint64_t(seed) ^ std::uint64_t(value) * 0x9E3779B97F4A7C15u) * 0xBF58476D1CE4E5B9u;
+  return std::size_t(h ^ h >> 31);
+}
+
 /**
   * \class Element
   * \brief Interface for IntElement and VariableElement classes
@@ -40,6 +55,25 @@ public:
     */
   virtual int evaluate(const Valuation& val) const = 0;
 
+  /**
+    * \brief Abstract compile method for Element class
+    * \param code Bytecode to which instructions leaving value of Element on the stack are appended
+    */
+  virtual void compile(Bytecode& code) const = 0;
+
+  /**
+    * \brief Abstract structural hash method for Element class. Elements with equal toString have equal hashes
+    * \return Hash of Element
+    */
+  virtual std::size_t hash() const = 0;
+
+  /**
+    * \brief Abstract structural comparison method for Element class, equivalent to comparing toString
+    * \param e Element to be compared to self
+    * \return True if elements have the same structure and values, else false
+    */
+  virtual bool equals(const Element& e) const = 0;
+
 };
 
 /**
@@ -105,6 +139,28 @@ public:
     */
   int evaluate(const Valuation& v) const;
 
+  /**
+    * \brief Appends instruction pushing int value or variable to bytecode
+    * \param code Bytecode to be appended to
+    */
+  void compile(Bytecode& code) const;
+
+  /**
+    * \brief Returns hash of int value or variable
+    * \return Hash of element
+    */
+  std::size_t hash() const;
+
+  /**
+    * \brief Compares to element of same type
+    * \param e Element to be compared to self
+    * \return True if e is same type with equal value, else false
+    */
+  bool equals(const Element& e) const{
+    const TElement<T>* t = dynamic_cast<const TElement<T>*>(&e);
+    return t != nullptr && t->val == val;
+  };
+
   /**
     * \brief Operator overload for operator += for IntElements
     * \param i IntElement to be added to self
@@ -164,7 +220,8 @@ TElement<int> operator*(const TElement<int>& i1, const TElement<int>& i2);
 std::ostream& operator<<(std::ostream& os, const Element& i);
 
 /**
-  * \brief Operator overload for operator == for Element subclasses
+  * \brief Operator overload for operator == for Element subclasses. Compares hashes first, so
+           different elements are usually told apart without visiting their operands
   * \param e1 First Element to be compared
   * \param e2 Second Element to be compared
   * \return True if identical, false if not
@@ -5,6 +5,13 @@
 #include "catch.hpp"
 #include "element.h"
 #include "compositeelement.h"
+#include "bytecode.h"
+#include "valuationbatch.h"
+#include "elementbuilder.h"
+#include "polynomialelement.h"
+#include "cell.h"
+#include "sumelement.h"
+#include "dotproductelement.h"
 
 /**
   * \brief Tests for IntEelement constructors
@@ -235,7 +242,44 @@ TEST_CASE("Element operator== overload tests", "[element]"){
   CHECK_FALSE(one == x);
   CHECK_FALSE(one == comp);
 
+  // Separately built composites compare by structure, like their strings
+  CompositeElement same{IntElement{1}, VariableElement{'x'}, std::plus<int>{}, '+'};
+  CompositeElement swapped{x, one, std::plus<int>{}, '+'};
+  CompositeElement product{one, x, std::multiplies<int>{}, '*'};
+  CompositeElement nested{comp, product, std::minus<int>{}, '-'};
+  CompositeElement nestedSame{same, product, std::minus<int>{}, '-'};
+
+  CHECK(comp == same);
+  CHECK(nested == nestedSame);
+  CHECK_FALSE(comp == swapped);
+  CHECK_FALSE(comp == product);
+  CHECK_FALSE(nested == comp);
+}
+
+/**
+  * \brief Tests for structural hashes of Elements
+  */
+TEST_CASE("Element hash tests", "[element]"){
 
+  IntElement one{1};
+  VariableElement x{'x'};
+  CompositeElement comp{one, x, std::plus<int>{}, '+'};
+  CompositeElement same{IntElement{1}, VariableElement{'x'}, std::plus<int>{}, '+'};
+  CompositeElement copy{comp};
+
+  CHECK(one.hash() == IntElement{1}.hash());
+  CHECK(one.hash() != IntElement{2}.hash());
+  CHECK(x.hash() != VariableElement{'y'}.hash());
+  CHECK(comp.hash() == same.hash());
+  CHECK(comp.hash() == copy.hash());
+  CHECK(comp.hash() != CompositeElement(x, one, std::plus<int>{}, '+').hash());
+  CHECK(comp.hash() != CompositeElement(one, x, std::minus<int>{}, '-').hash());
+
+  // Equal strings mean equal hashes
+  CompositeElement deep{comp, comp, std::multiplies<int>{}, '*'};
+  CompositeElement deepSame{same, copy, std::multiplies<int>{}, '*'};
+  CHECK(deep.toString() == deepSame.toString());
+  CHECK(deep.hash() == deepSame.hash());
 }
 
 
@@ -329,4 +373,428 @@ TEST_CASE("CompositeElement evaluate tests", "[compositeelement]"){
   CHECK(first.evaluate(map) == 5);
   CHECK(second.evaluate(map) == 7);
   CHECK(third.evaluate(map) == 9);
-}
\ No newline at end of file
+
+  // Symbols other than '+', '-' and '*' keep their function
+  CompositeElement divide{z, two, std::divides<int>{}, '/'};
+  CHECK(first.opcode() == CompositeElement::Opcode::Add);
+  CHECK(divide.opcode() == CompositeElement::Opcode::Custom);
+  CHECK(divide.evaluate(map) == 3);
+  CHECK(CompositeElement{divide}.evaluate(map) == 3);
+  CHECK(std::unique_ptr<Element>{divide.clone()}->evaluate(map) == 3);
+
+  // Arithmetic wraps like compiled evaluation
+  IntElement largest{2147483647};
+  CHECK(CompositeElement(largest, one, std::plus<int>{}, '+').evaluate(map) == -2147483647 - 1);
+}
+
+/**
+  * \brief Tests for compiling Elements into Bytecode
+  */
+TEST_CASE("Element compile tests", "[compositeelement]"){
+
+  Valuation map{};
+  map['x'] = 4;
+  map['y'] = 5;
+
+  IntElement three{3};
+  VariableElement x{'x'};
+  VariableElement y{'y'};
+  CompositeElement sum{three, x, std::plus<int>{}, '+'};
+  CompositeElement difference{y, sum, std::minus<int>{}, '-'};
+  CompositeElement product{difference, x, std::multiplies<int>{}, '*'};
+
+  Bytecode code;
+  product.compile(code);
+
+  CHECK(code.maxDepth() == 3);
+  CHECK(code.variables().size() == 2);
+  CHECK(code.evaluate(map) == product.evaluate(map));
+
+  // Unmapped variables throw like in tree evaluation
+  Valuation partial{};
+  partial['x'] = 1;
+  CHECK_THROWS_AS(code.evaluate(partial), std::out_of_range);
+
+  Bytecode unknown;
+  CompositeElement divide{three, x, std::divides<int>{}, '/'};
+  CHECK_THROWS(divide.compile(unknown));
+}
+
+/**
+  * \brief Tests for Valuation class
+  */
+TEST_CASE("Valuation tests", "[valuation]"){
+
+  Valuation map{};
+  CHECK(map.empty());
+  CHECK_THROWS_AS(map.at('x'), std::out_of_range);
+
+  map['x'] = 4;
+  map['A'] = -2;
+  map['z'] = 7;
+  map['x'] += 1;
+
+  CHECK(map.size() == 3);
+  CHECK(map.at('x') == 5);
+  CHECK(map.at('A') == -2);
+  CHECK(map.count('z') == 1);
+  CHECK(map.count('y') == 0);
+  CHECK_THROWS_AS(map.at('y'), std::out_of_range);
+  CHECK_THROWS_AS(map.at('1'), std::out_of_range);
+  CHECK_THROWS(map['1']);
+
+  // Iterates in slot order, upper case first
+  std::string names;
+  for(const auto& val : map){
+    names += val.first;
+  }
+  CHECK(names == "Axz");
+
+  CHECK(map.erase('x') == 1);
+  CHECK(map.erase('x') == 0);
+  CHECK_THROWS_AS(map.at('x'), std::out_of_range);
+  map['x'];
+  CHECK(map.at('x') == 0);
+
+  std::map<char,int> old{{'a', 1}, {'B', 2}};
+  Valuation converted{old};
+  CHECK(converted.size() == 2);
+  CHECK(converted.at('a') == 1);
+  CHECK(converted.at('B') == 2);
+}
+
+/**
+  * \brief Tests for simplifying ElementBuilder
+  */
+TEST_CASE("ElementBuilder tests", "[compositeelement]"){
+
+  std::shared_ptr<const Element> zero = ElementBuilder::constant(0);
+  std::shared_ptr<const Element> one = ElementBuilder::constant(1);
+  std::shared_ptr<const Element> seven = ElementBuilder::constant(7);
+  std::shared_ptr<const Element> x = std::make_shared<const VariableElement>('x');
+  std::shared_ptr<const Element> y = std::make_shared<const VariableElement>('y');
+
+  // Constant folding wraps like evaluation
+  CHECK(ElementBuilder::add(seven, one)->toString() == "8");
+  CHECK(ElementBuilder::subtract(one, seven)->toString() == "-6");
+  CHECK(ElementBuilder::multiply(seven, seven)->toString() == "49");
+  CHECK(ElementBuilder::add(ElementBuilder::constant(2147483647), one)->toString() == "-2147483648");
+
+  // Identities and annihilators
+  CHECK(ElementBuilder::add(x, zero) == x);
+  CHECK(ElementBuilder::add(zero, x) == x);
+  CHECK(ElementBuilder::subtract(x, zero) == x);
+  CHECK(ElementBuilder::multiply(one, x) == x);
+  CHECK(ElementBuilder::multiply(x, one) == x);
+  CHECK(ElementBuilder::multiply(x, zero)->toString() == "0");
+  CHECK(ElementBuilder::multiply(zero, x)->toString() == "0");
+  CHECK(ElementBuilder::subtract(zero, x)->toString() == "(0-x)");
+
+  // Cancellation
+  std::shared_ptr<const Element> sum = ElementBuilder::add(x, y);
+  CHECK(ElementBuilder::subtract(x, std::make_shared<const VariableElement>('x'))->toString() == "0");
+  CHECK(ElementBuilder::subtract(sum, ElementBuilder::add(x, y))->toString() == "0");
+  CHECK(ElementBuilder::subtract(sum, y) == x);
+  CHECK(ElementBuilder::subtract(sum, x) == y);
+  CHECK(ElementBuilder::add(ElementBuilder::subtract(x, y), y) == x);
+  CHECK(ElementBuilder::add(y, ElementBuilder::subtract(x, y)) == x);
+
+  // Everything else is kept
+  CHECK(sum->toString() == "(x+y)");
+  CHECK(ElementBuilder::multiply(x, seven)->toString() == "(x*7)");
+  CHECK(ElementBuilder::subtract(sum, seven)->toString() == "((x+y)-7)");
+}
+
+/**
+  * \brief Tests for hash-consed composites
+  */
+TEST_CASE("CompositeElement make tests", "[compositeelement]"){
+
+  const std::size_t before = CompositeElement::sharedCount();
+  std::shared_ptr<const Element> x = std::make_shared<const VariableElement>('x');
+  std::shared_ptr<const Element> two = ElementBuilder::constant(2);
+
+  {
+    std::shared_ptr<const Element> sum = CompositeElement::make(x, two, std::plus<int>{}, '+');
+    std::shared_ptr<const Element> product = CompositeElement::make(sum, sum, std::multiplies<int>{}, '*');
+
+    // Ints and variables are identical by value, composites by address
+    CHECK(CompositeElement::make(std::make_shared<const VariableElement>('x'), ElementBuilder::constant(2), std::plus<int>{}, '+') == sum);
+    CHECK(CompositeElement::make(sum, sum, std::multiplies<int>{}, '*') == product);
+    CHECK(CompositeElement::make(two, x, std::plus<int>{}, '+') != sum);
+    CHECK(CompositeElement::make(x, two, std::minus<int>{}, '-') != sum);
+    CHECK(CompositeElement::sharedCount() == before + 2);
+
+    Valuation map{};
+    map['x'] = 5;
+    CHECK(product->evaluate(map) == 49);
+    CHECK(product->toString() == "((x+2)*(x+2))");
+  }
+
+  CHECK(CompositeElement::sharedCount() == before);
+
+  // Many composites, released out of creation order
+  std::vector<std::shared_ptr<const Element>> chain{x};
+  for(int i = 0; i < 10000; i++){
+    chain.push_back(CompositeElement::make(chain.back(), ElementBuilder::constant(i), std::plus<int>{}, '+'));
+  }
+  CHECK(CompositeElement::sharedCount() == before + 10000);
+  for(std::size_t i = 1; i < chain.size(); i += 2){
+    chain[i].reset();
+  }
+  CHECK(CompositeElement::sharedCount() == before + 10000);
+  chain.resize(5000);
+  CHECK(CompositeElement::sharedCount() == before + 4998);
+  CHECK(CompositeElement::make(chain[4998], ElementBuilder::constant(4998), std::plus<int>{}, '+')->toString() == chain[4998]->toString().insert(0, "(") + "+4998)");
+  chain.clear();
+  CHECK(CompositeElement::sharedCount() == before);
+}
+
+/**
+  * \brief Tests for PolynomialElement arithmetic and canonical form
+  */
+TEST_CASE("PolynomialElement tests", "[polynomialelement]"){
+
+  PolynomialElement x{'x'};
+  PolynomialElement y{'y'};
+  PolynomialElement two{2};
+
+  CHECK(PolynomialElement{}.toString() == "{0}");
+  CHECK(two.toString() == "{2}");
+  CHECK(x.toString() == "{x}");
+  CHECK_THROWS(PolynomialElement{'1'});
+
+  // Canonical form does not depend on how polynomial was built
+  PolynomialElement square = (x + y) * (x + y);
+  CHECK(square.toString() == "{x^2+2*x*y+y^2}");
+  CHECK(square == (y + x) * (y + x));
+  CHECK(square.hash() == ((y + x) * (y + x)).hash());
+  CHECK(((x + y) * (x - y)).toString() == "{x^2-y^2}");
+  CHECK((square - square).toString() == "{0}");
+  CHECK((square - x * x - two * x * y).variables() == std::vector<char>{'y'});
+  CHECK((x * x * x - two).toString() == "{x^3-2}");
+  CHECK_FALSE(square == x);
+
+  // Expanding composites
+  VariableElement vx{'x'};
+  VariableElement vy{'y'};
+  CompositeElement sum{vx, vy, std::plus<int>{}, '+'};
+  CompositeElement product{sum, sum, std::multiplies<int>{}, '*'};
+  CHECK(PolynomialElement::of(product) == square);
+  CHECK(PolynomialElement::of(IntElement{5}).toString() == "{5}");
+
+  Valuation map{};
+  map['x'] = 3;
+  map['y'] = -4;
+  CHECK(square.evaluate(map) == product.evaluate(map));
+
+  Bytecode code;
+  square.compile(code);
+  CHECK(code.evaluate(map) == 1);
+
+  // Powers compile into one instruction, evaluated by repeated squaring
+  PolynomialElement high = x * y;
+  for(int i = 0; i < 10; i++)
+    high = high * high;
+  CHECK(high.toString() == "{x^1024*y^1024}");
+  Bytecode power;
+  power.pushConstant(1);
+  power.pushVariable('x');
+  power.pushPower(1024);
+  power.pushOperation('*');
+  power.store(0);
+  Bytecode compiled;
+  high.compile(compiled);
+  compiled.store(0);
+  CHECK(compiled.instructions().size() <= 8);
+  int value = 0;
+  compiled.evaluate(map, &value);
+  CHECK(value == high.evaluate(map));
+
+  ValuationBatch batch{3};
+  for(std::size_t i = 0; i < 3; i++){
+    batch.set('x', i, int(i) + 2);
+    batch.set('y', i, -3);
+  }
+  int values[3];
+  int* out[3] = {&values[0], &values[1], &values[2]};
+  compiled.evaluate(batch, out);
+  for(std::size_t i = 0; i < 3; i++){
+    Valuation single{};
+    single['x'] = int(i) + 2;
+    single['y'] = -3;
+    CHECK(values[i] == high.evaluate(single));
+  }
+  // 2^1024 wraps to zero
+  power.evaluate(batch, out);
+  CHECK(values[0] == 0);
+  power.evaluate(map, &value);
+  CHECK(values[1] == value);
+
+  Valuation partial{};
+  partial['x'] = 1;
+  CHECK_THROWS_AS(square.evaluate(partial), std::out_of_range);
+
+  // Builder keeps polynomials as polynomials
+  std::shared_ptr<const Element> p = ElementBuilder::multiply(std::make_shared<const PolynomialElement>(x), std::make_shared<const VariableElement>('y'));
+  CHECK(p->toString() == "{x*y}");
+  CHECK(ElementBuilder::add(p, ElementBuilder::constant(1))->toString() == "{x*y+1}");
+}
+
+/**
+  * \brief Tests for Cell, CellStorage and CellBuilder
+  */
+TEST_CASE("Cell tests", "[cell]"){
+
+  CHECK(sizeof(Cell) == 8);
+  CHECK(Cell{} == Cell::integer(0));
+  CHECK(Cell::integer(-7).kind() == Cell::Kind::Int);
+  CHECK(Cell::integer(-7).value() == -7);
+  CHECK(Cell::integer(std::numeric_limits<int>::min()).value() == std::numeric_limits<int>::min());
+  CHECK(Cell::variable('z').kind() == Cell::Kind::Variable);
+  CHECK(Cell::variable('z').name() == 'z');
+  CHECK(Cell::node(41).index() == 41);
+  CHECK_FALSE(Cell::integer(120) == Cell::variable('x'));
+
+  CellNodes none;
+  CellNodes out;
+  const Cell x = Cell::variable('x');
+
+  // Ints fold with wrapping, and identities need no elements
+  CHECK(CellBuilder::add(Cell::integer(2), none, Cell::integer(3), none, out) == Cell::integer(5));
+  CHECK(CellBuilder::multiply(Cell::integer(std::numeric_limits<int>::max()), none, Cell::integer(2), none, out) == Cell::integer(-2));
+  CHECK(CellBuilder::add(Cell::integer(0), none, x, none, out) == x);
+  CHECK(CellBuilder::subtract(x, none, x, none, out) == Cell::integer(0));
+  CHECK(CellBuilder::multiply(x, none, Cell::integer(0), none, out) == Cell::integer(0));
+  CHECK(CellBuilder::multiply(Cell::integer(1), none, x, none, out) == x);
+  CHECK(out.empty());
+
+  // Expressions are appended to out and can be operands of further operations in the same list
+  CellStorage storage{};
+  const Cell sum = CellBuilder::add(x, none, Cell::integer(2), none, storage.nodes);
+  CHECK(sum == Cell::node(0));
+  const Cell product = CellBuilder::multiply(sum, storage.nodes, Cell::variable('y'), none, storage.nodes);
+  CHECK(product == Cell::node(1));
+  CHECK(CellBuilder::copy(product, storage.nodes, out) == Cell::node(0));
+  CHECK(out[0] == storage.nodes[1]);
+
+  std::string s;
+  storage.append(product, s);
+  s += ',';
+  storage.append(Cell::integer(-3), s);
+  CHECK(s == "((x+2)*y),-3");
+  CHECK(storage.hash(Cell::integer(-3)) == IntElement{-3}.hash());
+  CHECK(storage.hash(x) == VariableElement{'x'}.hash());
+  CHECK(storage.hash(sum) == storage.nodes[0]->hash());
+  CHECK(storage.equal(sum, CellStorage{{}, {CompositeElement::make(ElementBuilder::variable('x'), ElementBuilder::constant(2), std::plus<int>{}, '+')}}, Cell::node(0)));
+  CHECK_FALSE(storage.equal(sum, storage, x));
+
+  // Adopted ints and variables are inline, polynomials are kept as nodes so identities stay polynomial
+  CHECK(CellBuilder::adopt(std::unique_ptr<Element>{new IntElement{4}}, out) == Cell::integer(4));
+  CHECK(CellBuilder::adopt(ElementBuilder::variable('q'), out) == Cell::variable('q'));
+  CHECK(out.size() == 1);
+  const Cell poly = CellBuilder::adopt(std::make_shared<const PolynomialElement>(PolynomialElement::of(VariableElement{'x'})), out);
+  CHECK(poly == Cell::node(1));
+  const Cell zero = CellBuilder::multiply(poly, out, Cell::integer(0), none, out);
+  CHECK(zero.kind() == Cell::Kind::Node);
+  CHECK(out[zero.index()]->toString() == "{0}");
+}
+
+/**
+  * \brief Tests for SumElement and DotProductElement
+  */
+TEST_CASE("SumElement and DotProductElement tests", "[sumelement]"){
+
+  const std::shared_ptr<const Element> x = ElementBuilder::variable('x');
+  const std::shared_ptr<const Element> y = ElementBuilder::variable('y');
+  const std::shared_ptr<const Element> two = ElementBuilder::constant(2);
+  const std::shared_ptr<const Element> xy = ElementBuilder::multiply(x, y);
+
+  CHECK_THROWS(SumElement{{x}});
+  CHECK_THROWS(SumElement{{x, nullptr}});
+
+  Valuation map{};
+  map['x'] = 3;
+  map['y'] = -4;
+
+  // Reads, hashes and compares like the chain of composites it replaces
+  const SumElement sum{{x, xy, two}};
+  const std::shared_ptr<const Element> chain = ElementBuilder::add(ElementBuilder::add(x, xy), two);
+  CHECK(sum.count() == 3);
+  CHECK(sum.toString() == "((x+(x*y))+2)");
+  CHECK(sum.hash() == chain->hash());
+  CHECK(sum == *chain);
+  CHECK(*chain == sum);
+  CHECK_FALSE(sum == *ElementBuilder::add(x, xy));
+  CHECK(sum == SumElement{{ElementBuilder::add(x, xy), two}});
+  CHECK(SumElement{{ElementBuilder::add(x, xy), two}} == sum);
+  CHECK(*ElementBuilder::add(std::make_shared<const SumElement>(std::vector<std::shared_ptr<const Element>>{x, xy}), two) == sum);
+  CHECK(sum.evaluate(map) == -7);
+
+  Bytecode code;
+  sum.compile(code);
+  CHECK(code.evaluate(map) == -7);
+  CHECK(PolynomialElement::of(sum) == PolynomialElement::of(*chain));
+
+  // Cells of [[x,2][3,1]] * [[y,1][x,5]]
+  const CellStorage left{{Cell::variable('x'), Cell::integer(2), Cell::integer(3), Cell::integer(1)}, {}};
+  const CellStorage right{{Cell::variable('y'), Cell::integer(1), Cell::variable('x'), Cell::integer(5)}, {}};
+  DotProductElement::Operands operands{left, right, 2};
+  CellNodes out;
+  Cell cell{};
+
+  REQUIRE(DotProductElement::make(operands, 1, 1, out, cell));
+  CHECK(cell == Cell::integer(8));
+  CHECK(out.empty());
+
+  REQUIRE(DotProductElement::make(operands, 0, 0, out, cell));
+  REQUIRE(cell == Cell::node(0));
+  const Element& dot = *out[0];
+  const std::shared_ptr<const Element> expected = ElementBuilder::add(xy, ElementBuilder::multiply(two, x));
+  CHECK(dot.toString() == "((x*y)+(2*x))");
+  CHECK(dot.hash() == expected->hash());
+  CHECK(dot == *expected);
+  CHECK(*expected == dot);
+  CHECK(dynamic_cast<const SumElement&>(dot).terms().size() == 2);
+  CHECK(dot.evaluate(map) == -6);
+  CHECK(PolynomialElement::of(dot) == PolynomialElement::of(*expected));
+
+  // Each product is one multiply-add
+  Bytecode dotCode;
+  dot.compile(dotCode);
+  CHECK(dotCode.evaluate(map) == -6);
+  CHECK(dotCode.instructions().back().op == Bytecode::Opcode::MultiplyAdd);
+
+  const std::unique_ptr<Element> copy{dot.clone()};
+  CHECK(*copy == dot);
+
+  // Dot products of other operands, sums and chains are compared term by term
+  const CellStorage leftCopy{left};
+  DotProductElement::Operands others{leftCopy, right, 2};
+  CellNodes again;
+  REQUIRE(DotProductElement::make(others, 0, 0, again, cell));
+  CHECK(*again[0] == dot);
+  CHECK(dot == SumElement{{xy, ElementBuilder::multiply(two, x)}});
+  CHECK_FALSE(dot == SumElement{{xy, ElementBuilder::multiply(x, two)}});
+  CHECK_FALSE(dot == *ElementBuilder::add(xy, ElementBuilder::multiply(x, two)));
+  CHECK_FALSE(*out[0] == sum);
+
+  REQUIRE(DotProductElement::make(operands, 0, 1, out, cell));
+  CHECK(out[cell.index()]->toString() == "(x+10)");
+  REQUIRE(DotProductElement::make(operands, 1, 0, out, cell));
+  CHECK(out[cell.index()]->toString() == "((3*y)+x)");
+  CHECK(out[cell.index()]->evaluate(map) == -9);
+
+  // A single term is stored as itself
+  const CellStorage zeroes{{Cell::integer(0), Cell::variable('z'), Cell::integer(0), Cell::integer(0)}, {}};
+  DotProductElement::Operands single{zeroes, right, 2};
+  REQUIRE(DotProductElement::make(single, 0, 0, out, cell));
+  CHECK(dynamic_cast<const SumElement*>(out[cell.index()].get()) == nullptr);
+  CHECK(out[cell.index()]->toString() == "(z*x)");
+
+  // Polynomial operands are left to CellBuilder
+  const CellStorage poly{{Cell::node(0), Cell::integer(1), Cell::integer(1), Cell::integer(1)},
+                         {std::make_shared<const PolynomialElement>(PolynomialElement::of(*x))}};
+  DotProductElement::Operands polynomial{poly, right, 2};
+  CHECK_FALSE(DotProductElement::make(polynomial, 0, 0, out, cell));
+}
@@ -3,323 +3,385 @@
   * \brief Specializations for ElementaryMatrix class methods and functions
   */
 
+#include <unordered_map>
 #include "elementarymatrix.h"
+#include "gemm.h"
+#include "strassen.h"
+#include "vectorkernels.h"
+#include "threadpool.h"
+#include "compiledmatrix.h"
+#include "polynomialelement.h"
+#include "dotproductelement.h"
+#include "matrixparser.h"
+#include "matrixfile.h"
+
+namespace{
+
+  using ElementwiseKernel = void (*)(const int*, const int*, int*, std::size_t);
+
+  // Below this many values one thread keeps up with memory
+  constexpr std::size_t parallelElements = std::size_t(1) << 20;
+
+  // Values per parallel task, a multiple of the widest vector
+  constexpr std::size_t chunkElements = std::size_t(1) << 16;
+
+  /**
+    * \brief Returns cell in row i and column j of a product of symbolic matrices of size n. Intermediate
+             sums are stored in terms, which is cleared for every cell, so only the result reaches out
+    */
+  Cell dot(const CellStorage& a, std::size_t i, const CellStorage& b, std::size_t j, std::size_t n, CellNodes& terms, CellNodes& out){
+
+    terms.clear();
+
+    Cell sum = CellBuilder::multiply(a.cells[i * n], a.nodes, b.cells[j], b.nodes, terms);
+    for(std::size_t k = 1; k < n; k++){
+      const Cell product = CellBuilder::multiply(a.cells[i * n + k], a.nodes, b.cells[k * n + j], b.nodes, terms);
+      sum = CellBuilder::add(sum, terms, product, terms, terms);
+    }
+
+    return CellBuilder::copy(sum, terms, out);
+  }
+
+  /**
+    * \brief Runs elementwise kernel over count values, in chunks on the shared ThreadPool for large counts
+    */
+  void elementwise(ElementwiseKernel kernel, const int* a, const int* b, int* dst, std::size_t count){
+
+    ThreadPool& pool = ThreadPool::shared();
+
+    if(pool.size() == 1 || count < parallelElements){
+      kernel(a, b, dst, count);
+      return;
+    }
+
+    pool.parallelFor((count + chunkElements - 1) / chunkElements, [&](std::size_t chunk){
+      const std::size_t begin = chunk * chunkElements;
+      kernel(a + begin, b + begin, dst + begin, std::min(chunkElements, count - begin));
+    });
+  }
+
+}
 
 template<>
 bool ElementarySquareMatrix<IntElement>::isSquareMatrix(const std::string& s){
-  
-  int num;
-  char delim;
-  int nums = 0;
-  int finalNums = -1;
-  int rows = 0;
-  std::stringstream ss;
 
-  ss << s;
+  return parseSquareMatrix(s, firstRowLength(s), false, [](std::size_t, const MatrixCell&){});
+}
 
-  // Checking for first '['
-  ss >> delim;
-  if(delim != '[')
-    return false;
+template<>
+bool ElementarySquareMatrix<Element>::isSquareMatrix(const std::string& s){
 
-  ss >> delim;
+  return parseSquareMatrix(s, firstRowLength(s), true, [](std::size_t, const MatrixCell&){});
+}
 
-  // Repeat until first ']'
-  while(delim != ']'){
+template<>
+std::vector<std::vector<std::unique_ptr<IntElement>>> ElementarySquareMatrix<IntElement>::matrixIntoVector(const std::string& s) const{
 
-    // Checking for second '['
-    if(delim != '[')
-      return false;
+  const std::size_t size = firstRowLength(s);
+  std::vector<std::vector<std::unique_ptr<IntElement>>> els(size);
 
-    do{
+  for(auto& row : els)
+    row.reserve(size);
 
-      // Checking for integer
-      ss >> num;
+  auto add = [&](std::size_t i, const MatrixCell& cell){
+    els[i / size].push_back(std::unique_ptr<IntElement>{new IntElement{cell.value}});
+  };
 
-      if(!ss.good())
-        return false;
+  if(!parseSquareMatrix(s, size, false, add))
+    throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
 
-      // Checking for ',' or ']'
-      ss >> delim;
-      if(delim != ',' && delim != ']')
-        return false;
+  return els;
+}
 
-      nums++; // Counting the number of nums in a row
+template<>
+std::vector<std::vector<std::unique_ptr<Element>>> ElementarySquareMatrix<Element>::matrixIntoVector(const std::string& s) const{
 
-    } while(delim != ']'); // Repeat until first ']'
+  const std::size_t size = firstRowLength(s);
+  std::vector<std::vector<std::unique_ptr<Element>>> els(size);
 
-    // Rows and nums need to be equal in square matrix
-    if(finalNums == -1)
-      finalNums = nums;
-    if(finalNums != nums)
-      return false;
+  for(auto& row : els)
+    row.reserve(size);
 
-    nums = 0; // Resetting numbers in row
+  // Creating VariableElement if char, else IntElement
+  auto add = [&](std::size_t i, const MatrixCell& cell){
+    if(cell.variable != '\0')
+      els[i / size].push_back(std::unique_ptr<VariableElement>{new VariableElement{cell.variable}});
+    else
+      els[i / size].push_back(std::unique_ptr<IntElement>{new IntElement{cell.value}});
+  };
 
-    // Making sure the string does not end with first ']'
-    ss >> delim;
-    if(!ss.good())
-      return false;
+  if(!parseSquareMatrix(s, size, true, add))
+    throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
+
+  return els;
+}
+
+template<>
+std::vector<std::vector<std::unique_ptr<IntElement>>> ElementarySquareMatrix<IntElement>::emptyMatrixIntoVector(const int n) const{
+
+  std::vector<std::vector<std::unique_ptr<IntElement>>> els;
 
-    rows++; // Counting the number of rows in matrix
+  for(int i = 0; i < n; i++){
+    els.push_back(std::vector<std::unique_ptr<IntElement>>());
+    for(int j = 0; j < n; j++){
+    els[i].push_back(std::unique_ptr<IntElement>{new IntElement{0}});
+    }
   }
+  return els;
+}
 
-  if(finalNums != rows)
-    return false;
+template<>
+std::vector<std::vector<std::unique_ptr<Element>>> ElementarySquareMatrix<Element>::emptyMatrixIntoVector(const int n) const{
 
-  // Checking, that ss is clear after final ']'
-  std::string right;
-  ss >> right;
-  if(right != "")
-    return false;
+  std::vector<std::vector<std::unique_ptr<Element>>> els;
 
-  return true;
+  for(int i = 0; i < n; i++){
+    els.push_back(std::vector<std::unique_ptr<Element>>());
+    for(int j = 0; j < n; j++){
+    els[i].push_back(std::unique_ptr<Element>{new VariableElement{'x'}});
+    }
+  }
+  return els;
 }
 
 template<>
-bool ElementarySquareMatrix<Element>::isSquareMatrix(const std::string& s){
+std::string ElementarySquareMatrix<IntElement>::toString() const{
 
-  char variable = ' ';
-  int num = 0;
-  char delim = ' ';
-  int vars = 0;
-  int finalVars = -1;
-  int rows = 0;
   std::stringstream ss;
 
-  ss << s;
+  ss << '[';
 
-  // Checking for first '['
-  ss >> delim;
-  if(delim != '[')
-    return false;
+  for(int i = 0; i < n; i++){
+    ss << '[';
+    for(int j = 0; j < n; j++){
+      if(j != 0)
+        ss << ',';
+      ss << elements[i * n + j];
+    }
+    ss << ']';
+  }
 
-  ss >> delim;
+  ss << ']';
 
-  // Repeat until first ']'
-  while(delim != ']'){
+  return ss.str();
+}
 
-    // Checking for second '['
-    if(delim != '[')
-      return false;
+template<>
+std::string ElementarySquareMatrix<Element>::toString() const{
 
-    do{
+  std::string s{'['};
 
-      // Checking for char
-      ss >> num;
+  for(std::size_t i = 0; i < n; i++){
+    s += '[';
+    for(std::size_t j = 0; j < n; j++){
+      if(j != 0)
+        s += ',';
+      elements.append(elements.cells[i * n + j], s);
+    }
+    s += ']';
+  }
 
-      if(!ss.good()){
-        ss.clear();
-        ss >> variable;
-        if(ss.eof()){
-          return false;
-        }
-        if(!std::isalpha(variable)){
-          return false;
-        }
-      }
+  s += ']';
 
-      ss >> delim;
-      // Checking for ',' or ']'
-      if(delim != ',' && delim != ']')
-        return false;
+  return s;
+}
 
-      vars++; // Counting the number of vars in a row
+template<>
+bool ElementarySquareMatrix<IntElement>::operator==(const ElementarySquareMatrix<IntElement>& m) const{
 
-    } while(delim != ']'); // Repeat until first ']'
+  return n == m.n && std::equal(elements.begin(), elements.end(), m.elements.begin());
+}
 
-    // Rows and vars need to be equal in square matrix
-    if(finalVars == -1)
-      finalVars = vars;
-    if(finalVars != vars)
-      return false;
-    vars = 0; // Resetting numbers in row
+template<>
+bool ElementarySquareMatrix<Element>::operator==(const ElementarySquareMatrix<Element>& m) const{
 
-    // Making sure the string does not end with first ']'
-    ss >> delim;
-    if(!ss.good())
-      return false;
+  if(n != m.n)
+    return false;
 
-    rows++; // Counting the number of rows in matrix
+  for(std::size_t i = 0; i < elements.cells.size(); i++){
+    if(!elements.equal(elements.cells[i], m.elements, m.elements.cells[i]))
+      return false;
   }
 
-  if(finalVars != rows)
-    return false;
-  // Checking, that ss is clear after final ']'
-  std::string right;
-  ss >> right;
-  if(right != "")
-    return false;
-
   return true;
 }
 
 template<>
-std::vector<std::vector<std::unique_ptr<IntElement>>> ElementarySquareMatrix<IntElement>::matrixIntoVector(const std::string& s) const{
+std::size_t ElementarySquareMatrix<IntElement>::hash() const{
 
-  int num;
-  char delim;
-  int rows = 0;
-  int nums = 0;
-  std::stringstream ss;
-  std::vector<std::vector<std::unique_ptr<IntElement>>> els;
+  return hashCombine(n, payloadChecksum(elements.data(), elements.size() * sizeof(int)));
+}
 
-  ss << s;
+template<>
+std::size_t ElementarySquareMatrix<Element>::hash() const{
 
-  ss >> delim;  // Removing first '[' from stringstream
-  ss >> delim;  // Removing second '[' from stringstream
+  // Element hashes are stored in composites, so this does not walk expressions
+  std::size_t h = n;
 
-  while(delim != ']'){
-    els.push_back(std::vector<std::unique_ptr<IntElement>>());
-    do{
-      ss >> num;
-      els[rows].push_back(std::unique_ptr<IntElement>{new IntElement{num}});
-      ss >> delim;  // Removing ',' or ']' from stringstream
-      nums++;
-    } while(delim != ']');
-
-    ss >> delim;  // Removing final ']' from stringstream
-    rows++;
+  for(const Cell& c : elements.cells){
+    h = hashCombine(h, elements.hash(c));
   }
 
-  return els;
+  return h;
 }
 
 template<>
-std::vector<std::vector<std::unique_ptr<Element>>> ElementarySquareMatrix<Element>::matrixIntoVector(const std::string& s) const{
+ElementarySquareMatrix<IntElement>::ElementarySquareMatrix(const unsigned int length) : n{length}, elements(std::size_t(length) * length){}
 
-  char variable;
-  int num = 0;
-  char delim;
-  int rows = 0;
-  std::stringstream ss;
-  std::vector<std::vector<std::unique_ptr<Element>>> els;
+template<>
+ElementarySquareMatrix<Element>::ElementarySquareMatrix(const unsigned int length) : n{length}{
 
-  ss << s;
+  elements.cells.assign(std::size_t(length) * length, Cell::variable('x'));
+}
 
-  ss >> delim;  // Removing first '[' from stringstream
-  ss >> delim;  // Removing second '[' from stringstream
+template<>
+ElementarySquareMatrix<IntElement>::ElementarySquareMatrix(const std::string& str_m){
 
-  while(delim != ']'){
-    els.push_back(std::vector<std::unique_ptr<Element>>());
-    do{
-      
-      // Creating VariableElement if char, else IntElement
-      ss >> num;
-
-      if(!ss.good()){
-        ss.clear();
-        ss >> variable;
-        if(std::isalpha(variable)){
-          els[rows].push_back(std::unique_ptr<VariableElement>{new VariableElement{variable}});
-        }
-      }
-      else{
-        els[rows].push_back(std::unique_ptr<IntElement>{new IntElement{num}});
-      }
+  // Size is known from the first row, so values are parsed straight into storage
+  const std::size_t size = firstRowLength(str_m);
+  DenseBuffer cells = DenseBuffer::uninitialized(size * size);
 
-      ss >> delim;
-    } while(delim != ']');
+  auto store = [&](std::size_t i, const MatrixCell& cell){
+    cells[i] = cell.value;
+  };
 
-    ss >> delim;  // Removing final ']' from stringstream
-    rows++;
-  }
+  if(!parseSquareMatrix(str_m, size, false, store))
+    throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
 
-  return els;
+  n = size;
+  elements = std::move(cells);
 }
 
 template<>
-std::vector<std::vector<std::unique_ptr<IntElement>>> ElementarySquareMatrix<IntElement>::emptyMatrixIntoVector(const int n) const{
+ElementarySquareMatrix<Element>::ElementarySquareMatrix(const std::string& str_m){
 
-  std::vector<std::vector<std::unique_ptr<IntElement>>> els;
+  // Ints and variables are stored inline, so parsing allocates nothing but the cells
+  const std::size_t size = firstRowLength(str_m);
+  std::vector<Cell> cells(size * size);
 
+  auto store = [&](std::size_t i, const MatrixCell& cell){
+    cells[i] = cell.variable != '\0' ? Cell::variable(cell.variable) : Cell::integer(cell.value);
+  };
+
+  if(!parseSquareMatrix(str_m, size, true, store))
+    throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
+
+  n = size;
+  elements.cells = std::move(cells);
+}
+
+template<>
+ElementarySquareMatrix<IntElement>::ElementarySquareMatrix(std::vector<std::vector<std::unique_ptr<IntElement>>> v) : n(v.size()), elements(DenseBuffer::uninitialized(v.size() * v.size())){
+
+  // Every row needs to hold n values for matrix to be square
   for(int i = 0; i < n; i++){
-    els.push_back(std::vector<std::unique_ptr<IntElement>>());
+    if(v[i].size() != n)
+      throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
+    for(const auto& el : v[i]){
+      if(!el)
+        throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
+    }
     for(int j = 0; j < n; j++){
-    els[i].push_back(std::unique_ptr<IntElement>{new IntElement{0}});
+      elements[i * n + j] = v[i][j]->getVal();
     }
   }
-  return els;
 }
 
 template<>
-std::vector<std::vector<std::unique_ptr<Element>>> ElementarySquareMatrix<Element>::emptyMatrixIntoVector(const int n) const{
+ElementarySquareMatrix<Element>::ElementarySquareMatrix(std::vector<std::vector<std::unique_ptr<Element>>> v) : n(v.size()){
+
+  // Shape is checked directly, so elements are adopted without printing and parsing them again
+  for(const auto& row : v){
+    if(row.size() != n)
+      throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
+    for(const auto& el : row){
+      if(!el)
+        throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
+    }
+  }
 
-  std::vector<std::vector<std::unique_ptr<Element>>> els;
+  elements.cells.reserve(std::size_t(n) * n);
+  for(auto& row : v){
+    for(auto& el : row){
+      elements.cells.push_back(CellBuilder::adopt(std::move(el), elements.nodes));
+    }
+  }
+}
+
+template<>
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::transpose() const{
+
+  // Every value is written, so transpose is not zeroed first
+  ConcreteSquareMatrix transpose{n, DenseBuffer::uninitialized(elements.size())};
 
   for(int i = 0; i < n; i++){
-    els.push_back(std::vector<std::unique_ptr<Element>>());
     for(int j = 0; j < n; j++){
-    els[i].push_back(std::unique_ptr<Element>{new VariableElement{'x'}});
+      transpose.elements[i * n + j] = elements[j * n + i];
     }
   }
-  return els;
+
+  return transpose;
 }
 
 template<>
-ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator+=(const ElementarySquareMatrix<IntElement>& m){
-  
-  ConcreteSquareMatrix copy = m;
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::transpose() const{
 
-  checkOperands(copy);
+  // Node indices stay valid, so transpose shares the node list and only moves cells
+  CellStorage transpose{std::vector<Cell>(elements.cells.size()), elements.nodes};
 
-  int rows = 0;
-  int nums = 0;
-
-  for(auto& row : elements){
-    for(auto& num : row){
-      *num = *num + *copy.elements[rows][nums];
-      nums++;
+  for(std::size_t i = 0; i < n; i++){
+    for(std::size_t j = 0; j < n; j++){
+      transpose.cells[i * n + j] = elements.cells[j * n + i];
     }
-    nums = 0;
-    rows++;
   }
 
+  return SymbolicSquareMatrix{n, std::move(transpose)};
+}
+
+template<>
+ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator+=(const ElementarySquareMatrix<IntElement>& m){
+
+  checkOperands(m);
+
+  elementwise(addInts, elements.data(), m.elements.data(), elements.data(), elements.size());
+
   return *this;
 }
 
 template<>
 ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator-=(const ElementarySquareMatrix<IntElement>& m){
-  
-  ConcreteSquareMatrix copy = m;
 
-  checkOperands(copy);
+  checkOperands(m);
 
-  int rows = 0;
-  int nums = 0;
-
-  for(auto& row : elements){
-    for(auto& num : row){
-      *num = *num - *copy.elements[rows][nums];
-      nums++;
-    }
-    nums = 0;
-    rows++;
-  }
+  elementwise(subtractInts, elements.data(), m.elements.data(), elements.data(), elements.size());
 
   return *this;
 }
 
 template<>
-ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator*=(const ElementarySquareMatrix<IntElement>& m){
-  
-  ConcreteSquareMatrix transpose = m;
-  checkOperands(transpose);
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator*(const ElementarySquareMatrix<IntElement>& m) const&{
+
+  checkOperands(m);
 
-  transpose = transpose.transpose();
-  
   // Initializing result as square matrix of correct size holding zeroes
-  ConcreteSquareMatrix result{};
-  result.elements = emptyMatrixIntoVector(n);
-  result.n = n;
+  ConcreteSquareMatrix result{n};
 
-  for(int i = 0; i < n; i++){
-    for(int j = 0; j < n; j++){
-      for(int k = 0; k < n; k++){
-        *result.elements[i][j] += *elements[i][k] * *transpose.elements[j][k];
-      }
-    }
-  }
+  strassenGemm(n, n, n, elements.data(), n, m.elements.data(), n, result.elements.data(), n);
+
+  return result;
+}
+
+template<>
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator*(const ElementarySquareMatrix<IntElement>& m) &&{
+
+  // Values of self are read until the last product, so the result needs its own buffer
+  return static_cast<const ConcreteSquareMatrix&>(*this) * m;
+}
+
+template<>
+ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator*=(const ElementarySquareMatrix<IntElement>& m){
+
+  ConcreteSquareMatrix result = *this * m;
 
   std::swap(elements, result.elements);
 
@@ -327,105 +389,210 @@ ElementarySquareMatrix<IntElement>& ElementarySquareMatrix<IntElement>::operator
 }
 
 template<>
-ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator+(const ElementarySquareMatrix<IntElement>& m) const{
-  ConcreteSquareMatrix result{*this};
-  result += m;
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator+(const ElementarySquareMatrix<IntElement>& m) const&{
+
+  checkOperands(m);
+
+  // Every value is written by the kernel, so result is not zeroed first
+  ConcreteSquareMatrix result{n, DenseBuffer::uninitialized(elements.size())};
+
+  elementwise(addInts, elements.data(), m.elements.data(), result.elements.data(), elements.size());
 
   return result;
 }
 
 template<>
-ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator+(const ElementarySquareMatrix<Element>& m) const{
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator+(const ElementarySquareMatrix<IntElement>& m) &&{
 
-  SymbolicSquareMatrix copy = m;
-  SymbolicSquareMatrix result{m};
+  *this += m;
 
-  checkOperands(copy);
+  return std::move(*this);
+}
 
-  for(int i = 0; i < n; i++){
-    for(int j = 0; j < n; j++){
-      CompositeElement el{*elements[i][j], *copy.elements[i][j], std::plus<int>{}, '+'};
-      result.elements[i][j] = std::unique_ptr<Element>{el.clone()};
-    }
+template<>
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator+(const ElementarySquareMatrix<Element>& m) const&{
+
+  checkOperands(m);
+
+  CellStorage result{std::vector<Cell>(elements.cells.size()), {}};
+
+  for(std::size_t i = 0; i < elements.cells.size(); i++){
+    result.cells[i] = CellBuilder::add(elements.cells[i], elements.nodes, m.elements.cells[i], m.elements.nodes, result.nodes);
   }
 
-  return result;
+  return SymbolicSquareMatrix{n, std::move(result)};
 }
 
 template<>
-ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator-(const ElementarySquareMatrix<IntElement>& m) const{
-  ConcreteSquareMatrix result{*this};
-  result -= m;
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator+(const ElementarySquareMatrix<Element>& m) &&{
+
+  checkOperands(m);
+
+  // Each cell is read before it is replaced, so m may be self. Results get a new node list,
+  // which releases the expressions no cell references anymore
+  CellNodes nodes;
+
+  for(std::size_t i = 0; i < elements.cells.size(); i++){
+    elements.cells[i] = CellBuilder::add(elements.cells[i], elements.nodes, m.elements.cells[i], m.elements.nodes, nodes);
+  }
+
+  elements.nodes = std::move(nodes);
+
+  return std::move(*this);
+}
+
+template<>
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator-(const ElementarySquareMatrix<IntElement>& m) const&{
+
+  checkOperands(m);
+
+  // Every value is written by the kernel, so result is not zeroed first
+  ConcreteSquareMatrix result{n, DenseBuffer::uninitialized(elements.size())};
+
+  elementwise(subtractInts, elements.data(), m.elements.data(), result.elements.data(), elements.size());
 
   return result;
 }
 
 template<>
-ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator-(const ElementarySquareMatrix<Element>& m) const{
-  
-  SymbolicSquareMatrix copy = m;
-  SymbolicSquareMatrix result{m};
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator-(const ElementarySquareMatrix<IntElement>& m) &&{
 
-  checkOperands(copy);
+  *this -= m;
 
-  for(int i = 0; i < n; i++){
-    for(int j = 0; j < n; j++){
-      CompositeElement el{*elements[i][j], *copy.elements[i][j], std::minus<int>{}, '-'};
-      result.elements[i][j] = std::unique_ptr<Element>{el.clone()};
-    }
+  return std::move(*this);
+}
+
+template<>
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator-(const ElementarySquareMatrix<Element>& m) const&{
+
+  checkOperands(m);
+
+  CellStorage result{std::vector<Cell>(elements.cells.size()), {}};
+
+  for(std::size_t i = 0; i < elements.cells.size(); i++){
+    result.cells[i] = CellBuilder::subtract(elements.cells[i], elements.nodes, m.elements.cells[i], m.elements.nodes, result.nodes);
   }
 
-  return result;
+  return SymbolicSquareMatrix{n, std::move(result)};
 }
 
 template<>
-ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::operator*(const ElementarySquareMatrix<IntElement>& m) const{
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator-(const ElementarySquareMatrix<Element>& m) &&{
 
-  ConcreteSquareMatrix temp{*this};
-  ConcreteSquareMatrix transpose = m;
-  checkOperands(transpose);
+  checkOperands(m);
 
-  transpose = transpose.transpose();
-  
-  // Initializing result as square matrix of correct size holding zeroes
-  ConcreteSquareMatrix result{};
-  result.elements = emptyMatrixIntoVector(n);
-  result.n = n;
+  CellNodes nodes;
 
-  for(int i = 0; i < n; i++){
-    for(int j = 0; j < n; j++){
-      for(int k = 0; k < n; k++){
-        *result.elements[i][j] += *temp.elements[i][k] * *transpose.elements[j][k];
-      }
+  for(std::size_t i = 0; i < elements.cells.size(); i++){
+    elements.cells[i] = CellBuilder::subtract(elements.cells[i], elements.nodes, m.elements.cells[i], m.elements.nodes, nodes);
+  }
+
+  elements.nodes = std::move(nodes);
+
+  return std::move(*this);
+}
+
+template<>
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator*(const ElementarySquareMatrix<Element>& m) const&{
+
+  checkOperands(m);
+
+  CellStorage result{std::vector<Cell>(elements.cells.size()), {}};
+  CellNodes terms;
+  DotProductElement::Operands operands{elements, m.elements, n};
+
+  // A cell is one dot product referencing rows and columns of both operands, which are copied once
+  // if any cell needs them. Ints are folded inline, and cells of polynomials and differences are
+  // built term by term since they simplify further
+  for(std::size_t i = 0; i < n; i++){
+    for(std::size_t j = 0; j < n; j++){
+      Cell& cell = result.cells[i * n + j];
+      if(!DotProductElement::make(operands, i, j, result.nodes, cell))
+        cell = dot(elements, i, m.elements, j, n, terms, result.nodes);
     }
   }
 
-  return result;
+  return SymbolicSquareMatrix{n, std::move(result)};
 }
 
 template<>
-ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator*(const ElementarySquareMatrix<Element>& m) const{
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator*(const ElementarySquareMatrix<Element>& m) &&{
 
-  SymbolicSquareMatrix transpose = m.transpose();
-  std::vector<std::unique_ptr<Element>> sums;
-  checkOperands(transpose);
-  int finalEls = 0;
-  
-  SymbolicSquareMatrix result{m};
+  // Dot products reference the cells of self, so they are never computed in place
+  return static_cast<const SymbolicSquareMatrix&>(*this) * m;
+}
 
-  for(int i = 0; i < n; i++){
-    for(int j = 0; j < n; j++, finalEls++){
-      for(int k = 0; k < n; k++){
-        sums.push_back(std::unique_ptr<Element>{new CompositeElement{*elements[i][k], *transpose.elements[j][k], std::multiplies<int>{}, '*'}});
-        if(k == 1){
-          result.elements[i][j] = std::unique_ptr<Element>{new CompositeElement{*sums[0], *sums[1], std::plus<int>{}, '+'}};
-        }
-        if(k > 1){
-          result.elements[i][j] = std::unique_ptr<Element>{new CompositeElement{*result.elements[i][j], *sums[k], std::plus<int>{}, '+'}};
-        }
+template<>
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::pow(unsigned int k) const{
+
+  const std::size_t size = elements.size();
+
+  if(k == 0){
+    ConcreteSquareMatrix result{n};
+    for(std::size_t i = 0; i < n; i++)
+      result.elements[i * n + i] = 1;
+    return result;
+  }
+
+  // Products are written into scratch and swapped in, so no buffer is allocated after the first three
+  DenseBuffer base{elements};
+  DenseBuffer power{};
+  DenseBuffer scratch = DenseBuffer::uninitialized(size);
+
+  auto multiply = [&](const DenseBuffer& a, const DenseBuffer& b){
+    std::fill(scratch.data(), scratch.data() + size, 0);
+    strassenGemm(n, n, n, a.data(), n, b.data(), n, scratch.data(), n);
+  };
+
+  bool first = true;
+  for(;;){
+    if(k & 1){
+      if(first){
+        power = base;
+        first = false;
+      }
+      else{
+        multiply(power, base);
+        std::swap(power, scratch);
       }
-      sums.clear();
     }
+    k >>= 1;
+    if(k == 0)
+      break;
+    multiply(base, base);
+    std::swap(base, scratch);
+  }
+
+  return ConcreteSquareMatrix{n, std::move(power)};
+}
+
+template<>
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::pow(unsigned int k) const{
+
+  if(k == 0){
+    // Identity is all ints, so it has no nodes
+    CellStorage identity{std::vector<Cell>(std::size_t(n) * n, Cell::integer(0)), {}};
+    for(std::size_t i = 0; i < n; i++)
+      identity.cells[i * n + i] = Cell::integer(1);
+    return SymbolicSquareMatrix{n, std::move(identity)};
+  }
+
+  SymbolicSquareMatrix result{};
+  SymbolicSquareMatrix base{*this};
+  bool first = true;
+
+  for(;;){
+    if(k & 1){
+      if(first)
+        result = base;
+      else
+        result = std::move(result) * base;
+      first = false;
+    }
+    k >>= 1;
+    if(k == 0)
+      break;
+    base = base * base;
   }
 
   return result;
@@ -433,17 +600,58 @@ ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::operator*(const
 
 template<>
 ElementarySquareMatrix<IntElement> ElementarySquareMatrix<Element>::evaluate(const Valuation& val) const{
-  
-  std::vector<std::vector<std::unique_ptr<IntElement>>> concreteEls;
 
-  for(int i = 0; i < n; i++){
-    concreteEls.push_back(std::vector<std::unique_ptr<IntElement>>());
-    for(int j = 0; j < n; j++){
-      concreteEls[i].push_back(std::unique_ptr<IntElement>{new IntElement{elements[i][j]->evaluate(val)}});
+  // Compiled program computes subexpressions shared between elements once
+  return CompiledSquareMatrix{*this}.evaluate(val);
+}
+
+template<>
+std::vector<ElementarySquareMatrix<IntElement>> ElementarySquareMatrix<Element>::evaluate(const ValuationBatch& batch) const{
+
+  return CompiledSquareMatrix{*this}.evaluate(batch);
+}
+
+template<>
+ElementarySquareMatrix<Element> ElementarySquareMatrix<Element>::toPolynomial() const{
+
+  CellStorage result{std::vector<Cell>(elements.cells.size()), {}};
+
+  // Elements and subexpressions shared between cells are converted once. Ints are created for
+  // conversion and freed after it, so their addresses are not cached
+  PolynomialElement::Cache expanded;
+  std::unordered_map<const Element*, Cell> converted;
+
+  for(std::size_t i = 0; i < elements.cells.size(); i++){
+    const Cell c = elements.cells[i];
+    const std::shared_ptr<const Element> el = elements.element(c);
+    if(c.kind() == Cell::Kind::Int){
+      result.cells[i] = CellBuilder::adopt(std::make_shared<const PolynomialElement>(PolynomialElement::of(*el)), result.nodes);
+      continue;
+    }
+    auto found = converted.find(el.get());
+    if(found == converted.end()){
+      const Cell poly = CellBuilder::adopt(std::make_shared<const PolynomialElement>(PolynomialElement::of(*el, expanded)), result.nodes);
+      found = converted.emplace(el.get(), poly).first;
     }
+    result.cells[i] = found->second;
   }
 
-  ConcreteSquareMatrix result{std::move(concreteEls)};
+  return SymbolicSquareMatrix{n, std::move(result)};
+}
 
-  return result;
-};
\ No newline at end of file
+template<>
+void ElementarySquareMatrix<IntElement>::save(const std::string& path) const{
+
+  saveMatrixFile(path, n, elements.data());
+}
+
+template<>
+ElementarySquareMatrix<IntElement> ElementarySquareMatrix<IntElement>::load(const std::string& path, bool verify){
+
+  std::size_t size = 0;
+  ConcreteSquareMatrix m{};
+  m.elements = loadMatrixFile(path, size, verify);
+  m.n = size;
+
+  return m;
+}
@@ -6,7 +6,36 @@
 #include <vector>
 #include <algorithm>
 #include <cctype>
+#include "cell.h"
 #include "compositeelement.h"
+#include "densebuffer.h"
+
+class CompiledSquareMatrix;
+class ExactSquareMatrix;
+class LazyMatrix;
+class ModularSquareMatrix;
+class SparseSquareMatrix;
+class ValuationBatch;
+
+/**
+  * \class MatrixStorage
+  * \brief Selects storage of ElementarySquareMatrix. SymbolicSquareMatrix stores 8-byte Cells inline in one
+           row-major vector, so ints and variables cost no more than values of ConcreteSquareMatrix. Only
+           expressions are shared Elements, which are immutable, so copies and results of operations
+           reference them instead of cloning them
+  */
+template <typename T>
+struct MatrixStorage{
+  using type = CellStorage;
+};
+
+/**
+  * \brief ConcreteSquareMatrix stores plain ints in one row-major DenseBuffer
+  */
+template <>
+struct MatrixStorage<TElement<int>>{
+  using type = DenseBuffer;
+};
 
 /**
   * \class ElementarySquareMatrix
@@ -47,64 +76,35 @@ public:
     * \brief Constructor for ElementarySquareMatrix of size n filled with zeroes.
     * \param n Size of created ElementarySquareMatrix
     */
-  ElementarySquareMatrix(const unsigned int length) : n{length}, elements{emptyMatrixIntoVector(length)}{};
+  ElementarySquareMatrix(const unsigned int length);
 
   /**
-    * \brief Constructor for ElementarySquareMatrix class. Checks with isSquareMatrix that parameter is correct,
-             then constructs elements using matrixIntoVector
+    * \brief Constructor for ElementarySquareMatrix class. Validates parameter and constructs elements in one pass,
+             throws exception if it is not a square matrix
     * \param s String with square matrix in [[i11,...,i1n]...[in2,...,inn]] format
   */
-  ElementarySquareMatrix(const std::string& str_m){
-    
-    if(!isSquareMatrix(str_m))
-      throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
-
-    elements = matrixIntoVector(str_m);
-    n = elements.size();
-  };
+  ElementarySquareMatrix(const std::string& str_m);
 
   /**
-    * \brief Constructor using vector for ElementarySquareMatrix class. If SquareMatrix doesn't adhere to proper form, throws exception.
+    * \brief Constructor using vector for ElementarySquareMatrix class. Elements are adopted, not cloned.
+             If rows are not all as long as there are rows or an element is missing, throws exception.
     * \param v Vector of vectors of IntElements or Elements, contains a SquareMatrix 
     */
-  ElementarySquareMatrix(const std::vector<std::vector<std::unique_ptr<T>>> v){
-
-    for(int i = 0; i < v.size(); i++){
-      elements.push_back(std::vector<std::unique_ptr<T>>());
-      for(int j = 0; j < v[i].size(); j++){
-        elements[i].push_back(std::unique_ptr<T>{v[i][j]->clone()});
-      }
-    }
-
-    n = elements.size();
-    
-    if(!isSquareMatrix(toString())){
-      throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
-    }
-  }
+  ElementarySquareMatrix(std::vector<std::vector<std::unique_ptr<T>>> v);
 
   /**
     * \brief Copy constructor for ElementarySquareMatrix class
     * \param m ElementarySquareMatrix to be copied
     */
-  ElementarySquareMatrix(const ElementarySquareMatrix<T>& m) : n{m.n}{
-    
-    int i = 0;
-
-    for(auto& rows : m.elements){
-      elements.push_back(std::vector<std::unique_ptr<T>>());
-      for(auto& el : rows){
-        elements[i].push_back(std::unique_ptr<T>{dynamic_cast<T*>(el->clone())});
-      }
-      i++;
-    }
-  };
+  ElementarySquareMatrix(const ElementarySquareMatrix<T>& m) : n{m.n}, elements{m.elements}{};
 
   /**
     * \brief Move copy constructor for ElementarySquareMatrix class
     * \param m ElementarySquareMatrix to be moved and copied
     */
-  ElementarySquareMatrix(ElementarySquareMatrix<T>&& m) : n{std::move(m.n)}, elements{std::move(m.elements)}{};
+  ElementarySquareMatrix(ElementarySquareMatrix<T>&& m) : n{m.n}, elements{std::move(m.elements)}{
+    m.n = 0;
+  };
 
   /**
     * \brief Virtual destructor for ElementarySquareMatrix class
@@ -133,7 +133,7 @@ public:
     */
   ElementarySquareMatrix<T>& operator=(ElementarySquareMatrix<T>&& m){
     
-    if(elements == m.elements){
+    if(this == &m){
       return *this;
     }
 
@@ -143,25 +143,19 @@ public:
     return *this;
   };
 
+  /**
+    * \brief Getter for size
+    * \return Number of rows and columns
+    */
+  unsigned int size() const{
+    return n;
+  };
+
   /**
     * \brief Returns transpose of self
     * \return ElementarySquareMatrix that is transpose of self
     */
-  ElementarySquareMatrix<T> transpose() const{
-    
-    ElementarySquareMatrix<T> transpose{};
-
-    for(int i = 0; i < n; i++){
-      transpose.elements.push_back(std::vector<std::unique_ptr<T>>());
-      for(int j = 0; j < n; j++){
-        transpose.elements[i].push_back(std::unique_ptr<T>{dynamic_cast<T*>(elements[j][i]->clone())});
-      }
-    }
-
-    transpose.n = n;
-
-    return transpose;
-  };
+  ElementarySquareMatrix<T> transpose() const;
 
   /**
     * \brief Operator overload for operator += for ConcreteSquareMatrix class
@@ -191,7 +185,15 @@ public:
     * \param m ElemenetarySquareMatrix to be added to copy of self
     * \return ElemenetarySquareMatrix with param added to copy of self
     */
-  ElementarySquareMatrix<T> operator+(const ElementarySquareMatrix<T>& m) const;
+  ElementarySquareMatrix<T> operator+(const ElementarySquareMatrix<T>& m) const&;
+
+  /**
+    * \brief Calculates sum into the storage of self when self is a temporary, so only the new values
+             are allocated: none for ConcreteSquareMatrix, only new expressions for SymbolicSquareMatrix
+    * \param m ElemenetarySquareMatrix to be added to self
+    * \return Self with param added
+    */
+  ElementarySquareMatrix<T> operator+(const ElementarySquareMatrix<T>& m) &&;
 
   /**
     * \brief Detracts param ElementarySquareMatrix from copy of self.
@@ -200,32 +202,53 @@ public:
     * \param m ElemenetarySquareMatrix to be detracted from copy of self
     * \return ElemenetarySquareMatrix with param detracted from copy of self
     */
-  ElementarySquareMatrix<T> operator-(const ElementarySquareMatrix<T>& m) const;
+  ElementarySquareMatrix<T> operator-(const ElementarySquareMatrix<T>& m) const&;
+
+  /**
+    * \brief Detracts param from the storage of self when self is a temporary
+    * \param m ElemenetarySquareMatrix to be detracted from self
+    * \return Self with param detracted
+    */
+  ElementarySquareMatrix<T> operator-(const ElementarySquareMatrix<T>& m) &&;
   
   /**
     * \brief Multiplies self by param ElementarySquareMatrix.
              For ConcreteSquareMatrix calculates result.
-             For SymbolicSquareMatrix makes CompositeElements.
+             For SymbolicSquareMatrix makes DotProductElements of cells with several terms.
     * \param m ElemenetarySquareMatrix to be multiplied with copy of self
     * \return ElemenetarySquareMatrix with param multiplied by copy of self
     */
-  ElementarySquareMatrix<T> operator*(const ElementarySquareMatrix<T>& m) const;
+  ElementarySquareMatrix<T> operator*(const ElementarySquareMatrix<T>& m) const&;
 
   /**
-    * \brief Checks, if param matrix is identical to self
+    * \brief Multiplies temporary self by param. Both operands are needed until the end, so the result
+             is allocated like in the const version
+    * \param m ElemenetarySquareMatrix to multiply self by
+    * \return Product of self and param
+    */
+  ElementarySquareMatrix<T> operator*(const ElementarySquareMatrix<T>& m) &&;
+
+  /**
+    * \brief Raises self to power k by repeated squaring, with at most 2 log2(k) products instead of k - 1.
+             ConcreteSquareMatrix reuses the same three buffers for every product
+    * \param k Exponent, 0 gives the identity matrix
+    * \return Self multiplied by itself k times
+    */
+  ElementarySquareMatrix<T> pow(unsigned int k) const;
+
+  /**
+    * \brief Checks, if param matrix is identical to self. Stops at the first differing element,
+             and symbolic elements are told apart by their structural hashes
     * \param m ElementarySquareMatrix
     * \return True if matrices are identical, false if not
     */
-  bool operator==(const ElementarySquareMatrix<T>& m) const{
-    
-    if(n != m.n)
-      return false;
+  bool operator==(const ElementarySquareMatrix<T>& m) const;
 
-    if(!(toString() == m.toString()))
-      return false;
-    else
-      return true;
-  };
+  /**
+    * \brief Returns hash of size and contents. Identical matrices have equal hashes
+    * \return Hash of matrix
+    */
+  std::size_t hash() const;
 
   /**
     * \brief Prints toString() to output stream
@@ -240,29 +263,7 @@ public:
     * \brief Returns matrix in predetermined string format
     * \return Matrix in predetermined string format
     */
-  std::string toString() const{
-
-    std::stringstream ss;
-    bool first = true;
-
-    ss << '[';
-
-    for(auto& row : elements){
-      first = true;
-      ss << '[';
-      for(auto& num : row){
-        if(!first)
-          ss << ',';
-        ss << *num;
-        first = false;
-      }
-      ss << ']';
-    }
-
-    ss << ']';
-
-    return ss.str();
-  };
+  std::string toString() const;
 
   /**
     * \brief Returns int values mapped to SymbolicSquareMatrix' char values
@@ -272,13 +273,47 @@ public:
     */
   ElementarySquareMatrix<IntElement> evaluate(const Valuation& val) const;
 
+  /**
+    * \brief Returns int values mapped to SymbolicSquareMatrix' char values for many valuations at once.
+             Elements are compiled once and evaluated for all valuations together
+    * \param batch Valuations stored as columns of variable values
+    * \return ConcreteSquareMatrix for every valuation, in order.
+              If a variable is not mapped in every valuation, throws exception
+    */
+  std::vector<ElementarySquareMatrix<IntElement>> evaluate(const ValuationBatch& batch) const;
+
+  /**
+    * \brief Returns SymbolicSquareMatrix whose elements are canonical PolynomialElements equal to own
+             elements. Operations on the result keep elements as polynomials, so their size depends on
+             the number of distinct monomials instead of the operations that built them
+    * \return SymbolicSquareMatrix of PolynomialElements
+    */
+  ElementarySquareMatrix<Element> toPolynomial() const;
+
+  /**
+    * \brief Writes ConcreteSquareMatrix into binary matrix file described in matrixfile.h.
+             Throws exception if file cannot be written
+    * \param path Path of file, replaced if it exists
+    */
+  void save(const std::string& path) const;
+
+  /**
+    * \brief Loads ConcreteSquareMatrix from binary matrix file. File is mapped into memory, so values are
+             not parsed or copied, and changes to the matrix are not written back to the file.
+             Throws exception if file cannot be read or is not a valid matrix file
+    * \param path Path of file
+    * \param verify Whether the checksum of values is checked
+    * \return ConcreteSquareMatrix using values of file
+    */
+  static ElementarySquareMatrix<T> load(const std::string& path, bool verify = true);
+
   /**
   * \brief Checks, whether two operands are empty and/or same size. If both are empty, throws exception. 
            If one is empty, creates empty matrix the same size as the other, but filled with zeroes. 
            If non-empty matrices are not the same size, throws exception.
   * \param m ElementarySquareMatrix to be compared to self
   */
-  void checkOperands(ElementarySquareMatrix<T>& m) const{
+  void checkOperands(const ElementarySquareMatrix<T>& m) const{
     
     // If matrices are different size, throw exception
     if(n != m.n){
@@ -287,10 +322,22 @@ public:
   };
   
 private:
+  /**
+    * \brief Trusted constructor adopting storage built by operations, which is not validated
+    * \param length Size of matrix
+    * \param storage Storage holding length * length cells or values
+    */
+  ElementarySquareMatrix(unsigned int length, typename MatrixStorage<T>::type&& storage) : n{length}, elements{std::move(storage)}{};
+
   unsigned int n;
-  std::vector<std::vector<std::unique_ptr<T>>> elements;
+  typename MatrixStorage<T>::type elements;
 
   friend class ElementarySquareMatrix<Element>;
+  friend class CompiledSquareMatrix;
+  friend class ExactSquareMatrix;
+  friend class LazyMatrix;
+  friend class ModularSquareMatrix;
+  friend class SparseSquareMatrix;
 
 };
 
@@ -308,6 +355,18 @@ std::ostream& operator<<(std::ostream& os, const ElementarySquareMatrix<T>& m){
   return os;
 }
 
+/**
+  * \brief Hash of ElementarySquareMatrix for unordered containers
+  */
+namespace std{
+  template<typename T>
+  struct hash<ElementarySquareMatrix<T>>{
+    std::size_t operator()(const ElementarySquareMatrix<T>& m) const{
+      return m.hash();
+    }
+  };
+}
+
 using ConcreteSquareMatrix = ElementarySquareMatrix<IntElement>;
 using SymbolicSquareMatrix = ElementarySquareMatrix<Element>;
 
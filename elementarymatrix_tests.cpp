@@ -2,8 +2,25 @@
   * \file elementarymatrix_tests.cpp
   * \brief Catch tests for ElementarySquareMatrix template class
   */
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
 #include "catch.hpp"
 #include "elementarymatrix.h"
+#include "gemm.h"
+#include "strassen.h"
+#include "vectorkernels.h"
+#include "threadpool.h"
+#include "compiledmatrix.h"
+#include "matrixparser.h"
+#include "sparsematrix.h"
+#include "modularmatrix.h"
+#include "exactmatrix.h"
+#include "lazymatrix.h"
+#include "calculator.h"
+#include "symbolicexpression.h"
+#include "elementbuilder.h"
 
 /**
   * \brief Tests for ConcreteSquareMatrix constructors
@@ -156,6 +173,544 @@ TEST_CASE("ConcreteSquareMatrix arithmetic operator overload tests", "[concretem
   CHECK(threeOne.toString() == "[[30,24,18][84,69,54][138,114,90]]");
 }
 
+/**
+  * \brief Tests for ConcreteSquareMatrix power by repeated squaring
+  */
+TEST_CASE("ConcreteSquareMatrix pow tests", "[concretematrix]"){
+
+  ConcreteSquareMatrix fibonacci{"[[1,1][1,0]]"};
+
+  CHECK(fibonacci.pow(0).toString() == "[[1,0][0,1]]");
+  CHECK(fibonacci.pow(1) == fibonacci);
+  CHECK(fibonacci.pow(10).toString() == "[[89,55][55,34]]");
+  CHECK(fibonacci.pow(46).toString() == "[[-1323752223,1836311903][1836311903,1134903170]]");
+  CHECK(ConcreteSquareMatrix{}.pow(3) == ConcreteSquareMatrix{});
+
+  // Same wrapped values as multiplying one factor at a time, also through Strassen-Winograd splitting
+  ConcreteSquareMatrix matrix{"[[1,2,3,4,5][6,7,8,9,10][11,12,13,14,15][16,17,18,19,20][21,22,23,24,-25]]"};
+  ConcreteSquareMatrix repeated = matrix;
+  for(unsigned int k = 2; k <= 13; k++){
+    repeated *= matrix;
+    CHECK(matrix.pow(k) == repeated);
+  }
+
+  setStrassenCrossover(2);
+  CHECK(matrix.pow(13) == repeated);
+  setStrassenCrossover(0);
+}
+
+/**
+  * \brief Tests for lazily evaluated expressions against eager operators
+  */
+TEST_CASE("ConcreteSquareMatrix lazy expression tests", "[concretematrix]"){
+
+  ConcreteSquareMatrix a{"[[1,2,3][4,5,6][7,8,9]]"};
+  ConcreteSquareMatrix b{"[[9,8,7][6,5,4][3,2,1]]"};
+  ConcreteSquareMatrix c{"[[2147483647,0,-1][1,-2147483648,2][3,3,3]]"};
+  ConcreteSquareMatrix d{"[[-5,0,5][0,-5,0][5,0,-5]]"};
+
+  ConcreteSquareMatrix sum = lazy(a) + b - c + d;
+  CHECK(sum == a + b - c + d);
+  CHECK(ConcreteSquareMatrix(lazy(a)) == a);
+  CHECK(ConcreteSquareMatrix(a - lazy(b)) == a - b);
+
+  // Products are accumulated onto the other terms, negated ones included
+  CHECK(ConcreteSquareMatrix(lazy(a) * b + c) == a * b + c);
+  CHECK(ConcreteSquareMatrix(c - lazy(a) * b) == c - a * b);
+  CHECK(ConcreteSquareMatrix(lazy(a) * b - lazy(c) * d + a) == a * b - c * d + a);
+  CHECK(ConcreteSquareMatrix((lazy(a) + b) * (lazy(c) - d)) == (a + b) * (c - d));
+  CHECK(ConcreteSquareMatrix(lazy(a) * b * c) == a * b * c);
+  CHECK(ConcreteSquareMatrix(d - (lazy(a) * b - c)) == d - (a * b - c));
+
+  // Operands are read before the result replaces them
+  ConcreteSquareMatrix aliased = a;
+  aliased = lazy(aliased) * aliased + aliased;
+  CHECK(aliased == a * a + a);
+
+  CHECK_THROWS(lazy(a) + ConcreteSquareMatrix{2});
+  CHECK_THROWS(lazy(a) * ConcreteSquareMatrix{2});
+
+  // Large enough for the fused loop to be split across threads
+  const std::size_t n = 1100;
+  std::stringstream text;
+  text << '[';
+  for(std::size_t i = 0; i < n; i++){
+    text << '[';
+    for(std::size_t j = 0; j < n; j++){
+      text << (j != 0 ? "," : "") << int((i * n + j) * 2654435761u);
+    }
+    text << ']';
+  }
+  text << ']';
+
+  ConcreteSquareMatrix big{text.str()};
+  ConcreteSquareMatrix other = big.transpose();
+  ThreadPool::setThreadCount(4);
+  CHECK(ConcreteSquareMatrix(lazy(big) + other - big + other) == big + other - big + other);
+  ThreadPool::setThreadCount(0);
+}
+
+/**
+  * \brief Tests for ConcreteSquareMatrix dense storage
+  */
+TEST_CASE("ConcreteSquareMatrix dense storage tests", "[concretematrix]"){
+
+  ConcreteSquareMatrix zero{3};
+  CHECK(zero.toString() == "[[0,0,0][0,0,0][0,0,0]]");
+
+  // Copies do not share storage
+  ConcreteSquareMatrix one{"[[1,2][3,4]]"};
+  ConcreteSquareMatrix copy{one};
+  copy += one;
+  CHECK(one.toString() == "[[1,2][3,4]]");
+  CHECK(copy.toString() == "[[2,4][6,8]]");
+
+  // Operand aliasing self
+  one *= one;
+  CHECK(one.toString() == "[[7,10][15,22]]");
+  one -= one;
+  CHECK(one.toString() == "[[0,0][0,0]]");
+
+  ConcreteSquareMatrix four{"[[1,0,0,2][0,1,0,0][0,0,1,0][3,0,0,1]]"};
+  CHECK(four.transpose().toString() == "[[1,0,0,3][0,1,0,0][0,0,1,0][2,0,0,1]]");
+  CHECK((four * four).toString() == "[[7,0,0,4][0,1,0,0][0,0,1,0][6,0,0,7]]");
+}
+
+/**
+  * \brief Tests for blocked gemm kernel against plain triple loop
+  */
+TEST_CASE("gemm kernel tests", "[concretematrix]"){
+
+  for(std::size_t n : {1, 5, 31, 97, 300}){
+
+    std::vector<int> a(n * n);
+    std::vector<int> b(n * n);
+    std::vector<int> c(n * n, 7);
+    std::vector<unsigned int> expected(n * n, 7);
+
+    // Large values make products wrap around
+    for(std::size_t i = 0; i < n * n; i++){
+      a[i] = int(i * 2654435761u);
+      b[i] = int(i * 40503u) - 20000;
+    }
+
+    for(std::size_t i = 0; i < n; i++)
+      for(std::size_t k = 0; k < n; k++)
+        for(std::size_t j = 0; j < n; j++)
+          expected[i * n + j] += unsigned(a[i * n + k]) * unsigned(b[k * n + j]);
+
+    gemm(n, n, n, a.data(), n, b.data(), n, c.data(), n);
+
+    CHECK(std::equal(c.begin(), c.end(), expected.begin(), [](int x, unsigned int y){ return unsigned(x) == y; }));
+  }
+}
+
+/**
+  * \brief Tests for Strassen-Winograd multiplication against blocked kernel
+  */
+TEST_CASE("Strassen-Winograd tests", "[concretematrix]"){
+
+  // Low crossover makes small products recurse through odd sizes
+  setStrassenCrossover(8);
+  CHECK(strassenCrossover() == 8);
+
+  for(std::size_t m : {9, 40, 77}){
+    for(std::size_t n : {17, 64}){
+      const std::size_t k = m + n / 2 + 3;
+
+      std::vector<int> a(m * k);
+      std::vector<int> b(k * n);
+      for(std::size_t i = 0; i < a.size(); i++)
+        a[i] = int(i * 2654435761u);
+      for(std::size_t i = 0; i < b.size(); i++)
+        b[i] = int(i * 40503u) - 20000;
+
+      std::vector<int> expected(m * n, 3);
+      std::vector<int> c(m * n, 3);
+      gemm(m, n, k, a.data(), k, b.data(), n, expected.data(), n);
+      strassenGemm(m, n, k, a.data(), k, b.data(), n, c.data(), n);
+
+      CHECK(c == expected);
+    }
+  }
+
+  ConcreteSquareMatrix matrix{"[[1,2,3,4,5,6,7,8,9,10,11][12,13,14,15,16,17,18,19,20,21,22]"
+                              "[23,24,25,26,27,28,29,30,31,32,33][34,35,36,37,38,39,40,41,42,43,44]"
+                              "[45,46,47,48,49,50,51,52,53,54,55][56,57,58,59,60,61,62,63,64,65,66]"
+                              "[67,68,69,70,71,72,73,74,75,76,77][78,79,80,81,82,83,84,85,86,87,88]"
+                              "[89,90,91,92,93,94,95,96,97,98,99][0,-1,-2,-3,-4,-5,-6,-7,-8,-9,-10]"
+                              "[2147483647,1,1,1,1,1,1,1,1,1,-2147483648]]"};
+  ConcreteSquareMatrix split = matrix * matrix;
+
+  setStrassenCrossover(0);
+  CHECK(strassenCrossover() > 8);
+  CHECK(split == matrix * matrix);
+}
+
+/**
+  * \brief Tests for SparseSquareMatrix constructors and conversions
+  */
+TEST_CASE("SparseSquareMatrix constructor tests", "[sparsematrix]"){
+
+  SparseSquareMatrix empty{};
+  CHECK(empty.size() == 0);
+  CHECK(empty.toString() == "[]");
+
+  SparseSquareMatrix zero{3};
+  CHECK(zero.nonZeros() == 0);
+  CHECK(zero.toString() == "[[0,0,0][0,0,0][0,0,0]]");
+
+  SparseSquareMatrix parsed{"[[0,2,0][ 0 , 0,0][-3,0,+4]]"};
+  CHECK(parsed.size() == 3);
+  CHECK(parsed.nonZeros() == 3);
+  CHECK(parsed.rows().starts == std::vector<std::size_t>{0, 1, 1, 3});
+  CHECK(parsed.rows().indices == std::vector<unsigned int>{1, 0, 2});
+  CHECK(parsed.rows().values == std::vector<int>{2, -3, 4});
+  CHECK(parsed.toString() == "[[0,2,0][0,0,0][-3,0,4]]");
+  CHECK(parsed.at(2, 0) == -3);
+  CHECK(parsed.at(1, 1) == 0);
+  CHECK_THROWS(parsed.at(3, 0));
+
+  CHECK_THROWS(SparseSquareMatrix{"[[1,2][3,4]"});
+  CHECK_THROWS(SparseSquareMatrix{"[[1,x][3,4]]"});
+
+  ConcreteSquareMatrix dense{"[[0,2,0][0,0,0][-3,0,4]]"};
+  CHECK(SparseSquareMatrix{dense} == parsed);
+  CHECK(parsed.toDense() == dense);
+
+  CompressedLines columns = parsed.columns();
+  CHECK(columns.starts == std::vector<std::size_t>{0, 1, 2, 3});
+  CHECK(columns.indices == std::vector<unsigned int>{2, 0, 2});
+  CHECK(columns.values == std::vector<int>{-3, 2, 4});
+  CHECK(parsed.transpose().toString() == "[[0,0,-3][2,0,0][0,0,4]]");
+
+  // Stored zeros are dropped, malformed rows rejected
+  SparseSquareMatrix adopted{3, CompressedLines{{0, 2, 2, 4}, {1, 2, 0, 2}, {2, 0, -3, 4}}};
+  CHECK(adopted == parsed);
+  CHECK_THROWS(SparseSquareMatrix{3, CompressedLines{{0, 1, 1}, {1}, {2}}});
+  CHECK_THROWS(SparseSquareMatrix{2, CompressedLines{{0, 2, 2}, {1, 0}, {2, 3}}});
+  CHECK_THROWS(SparseSquareMatrix{2, CompressedLines{{0, 1, 1}, {2}, {2}}});
+}
+
+/**
+  * \brief Tests for SparseSquareMatrix arithmetic against ConcreteSquareMatrix
+  */
+TEST_CASE("SparseSquareMatrix operation tests", "[sparsematrix]"){
+
+  SparseSquareMatrix one{"[[1,0,0][0,0,2][0,3,0]]"};
+  SparseSquareMatrix two{"[[-1,0,5][0,0,-2][0,0,0]]"};
+
+  CHECK((one + two).toString() == "[[0,0,5][0,0,0][0,3,0]]");
+  CHECK((one + two).nonZeros() == 2);
+  CHECK((one - one).nonZeros() == 0);
+  CHECK((one - two).toDense() == one.toDense() - two.toDense());
+  CHECK((one * two).toDense() == one.toDense() * two.toDense());
+  CHECK(one * two.toDense() == one.toDense() * two.toDense());
+  CHECK(one.toDense() * two == one.toDense() * two.toDense());
+  CHECK_THROWS(one + SparseSquareMatrix{2});
+  CHECK_THROWS(one * SparseSquareMatrix{2});
+  CHECK_THROWS(one * ConcreteSquareMatrix{2});
+
+  // Large enough to be split across threads, with values that overflow
+  const std::size_t n = 400;
+  CompressedLines a;
+  CompressedLines b;
+  a.starts.push_back(0);
+  b.starts.push_back(0);
+  for(std::size_t i = 0; i < n; i++){
+    for(unsigned int j = 0; j < n; j++){
+      const std::size_t cell = i * n + j;
+      if(cell * 2654435761u % 10 == 0){
+        a.indices.push_back(j);
+        a.values.push_back(int(cell * 40503u));
+      }
+      if(cell * 40503u % 9 == 0){
+        b.indices.push_back(j);
+        b.values.push_back(int(cell % 1000) - 500);
+      }
+    }
+    a.starts.push_back(a.values.size());
+    b.starts.push_back(b.values.size());
+  }
+
+  SparseSquareMatrix sa{n, a};
+  SparseSquareMatrix sb{n, b};
+  ConcreteSquareMatrix da = sa.toDense();
+  ConcreteSquareMatrix db = sb.toDense();
+  ConcreteSquareMatrix product = da * db;
+
+  ThreadPool::setThreadCount(4);
+  CHECK((sa * sb).toDense() == product);
+  CHECK(sa * db == product);
+  CHECK(da * sb == product);
+  CHECK((sa + sb).toDense() == da + db);
+  ThreadPool::setThreadCount(1);
+  CHECK((sa * sb).toDense() == product);
+  ThreadPool::setThreadCount(0);
+
+  CHECK(sa * sb == SparseSquareMatrix{product});
+  CHECK(sa.transpose().transpose() == sa);
+}
+
+/**
+  * \brief Tests for Modulus reduction
+  */
+TEST_CASE("Modulus tests", "[modularmatrix]"){
+
+  CHECK_THROWS(Modulus{0});
+  CHECK_THROWS(Modulus{1});
+  CHECK_THROWS(Modulus{91});
+  CHECK_THROWS(Modulus{2147483659u});
+  CHECK_NOTHROW(Modulus{2});
+
+  for(std::uint32_t p : {2u, 3u, 65537u, 2147483647u}){
+    Modulus mod{p};
+    CHECK(mod.value() == p);
+    CHECK(mod.fromInt(-1) == p - 1);
+    CHECK(mod.fromInt(-2147483647 - 1) == std::uint32_t((std::int64_t(-2147483647 - 1) % p + p) % p));
+    CHECK(mod.reduce(~std::uint64_t(0)) == ~std::uint64_t(0) % p);
+
+    std::uint64_t x = 1;
+    for(int i = 0; i < 200; i++){
+      x = x * 6364136223846793005u + 1442695040888963407u;
+      CHECK(mod.reduce(x) == x % p);
+    }
+
+    // Lazily summed products never overflow, and folding brings sums back below 2^63
+    const unsigned __int128 half = std::uint64_t(1) << 63;
+    const unsigned __int128 largest = std::uint64_t(p - 1) * (p - 1);
+    CHECK(mod.lazyProducts() >= 1);
+    CHECK(largest * mod.lazyProducts() + p <= half);
+    CHECK(mod.foldConstant() % p == 0);
+    CHECK(mod.foldConstant() <= half);
+    CHECK(mod.foldConstant() > half - p);
+  }
+}
+
+/**
+  * \brief Tests for ModularSquareMatrix constructors and operations against exact integer results
+  */
+TEST_CASE("ModularSquareMatrix tests", "[modularmatrix]"){
+
+  ModularSquareMatrix parsed{7, "[[-1,8][14,-15]]"};
+  CHECK(parsed.toString() == "[[6,1][0,6]]");
+  CHECK(parsed.prime() == 7);
+  CHECK(parsed.at(1, 1) == 6);
+  CHECK_THROWS(parsed.at(2, 0));
+  CHECK_THROWS(ModularSquareMatrix(8, "[[1]]"));
+  CHECK_THROWS(ModularSquareMatrix(7, "[[1,2][3]]"));
+  CHECK(ModularSquareMatrix(7, ConcreteSquareMatrix{"[[-1,8][14,-15]]"}) == parsed);
+  CHECK(parsed.toConcrete() == ConcreteSquareMatrix{"[[6,1][0,6]]"});
+  CHECK((parsed + parsed).toString() == "[[5,2][0,5]]");
+  CHECK((parsed - parsed + parsed - ModularSquareMatrix{7, 2}) == parsed);
+  CHECK((ModularSquareMatrix{7, 2} - parsed).toString() == "[[1,6][0,1]]");
+  CHECK((parsed * parsed).toString() == "[[1,5][0,1]]");
+  CHECK_THROWS(parsed + ModularSquareMatrix{7, 3});
+  CHECK_THROWS(parsed * ModularSquareMatrix{11, 2});
+
+  // Sizes off the row block and column tile, the larger one split across threads
+  ThreadPool::setThreadCount(4);
+
+  for(std::uint32_t p : {2u, 65537u, 2147483647u}){
+    for(std::size_t n : {37, 300}){
+
+      std::vector<int> a(n * n);
+      std::vector<int> b(n * n);
+      for(std::size_t i = 0; i < n * n; i++){
+        a[i] = int(i * 2654435761u);
+        b[i] = int(i * 40503u) - 20000;
+      }
+
+      std::stringstream sa;
+      std::stringstream sb;
+      sa << '[';
+      sb << '[';
+      for(std::size_t i = 0; i < n; i++){
+        sa << '[';
+        sb << '[';
+        for(std::size_t j = 0; j < n; j++){
+          sa << (j != 0 ? "," : "") << a[i * n + j];
+          sb << (j != 0 ? "," : "") << b[i * n + j];
+        }
+        sa << ']';
+        sb << ']';
+      }
+      sa << ']';
+      sb << ']';
+
+      ModularSquareMatrix ma{p, sa.str()};
+      ModularSquareMatrix mb{p, sb.str()};
+      ModularSquareMatrix product = ma * mb;
+      ModularSquareMatrix sum = ma + mb;
+      ModularSquareMatrix difference = ma - mb;
+
+      auto residue = [&](std::int64_t v){
+        return std::uint32_t((v % std::int64_t(p) + p) % p);
+      };
+
+      bool exact = true;
+      for(std::size_t i = 0; i < n && exact; i++){
+        for(std::size_t j = 0; j < n; j++){
+          std::int64_t expected = 0;
+          for(std::size_t k = 0; k < n; k++){
+            expected = (expected + std::int64_t(residue(a[i * n + k])) * residue(b[k * n + j])) % p;
+          }
+          exact = exact && product.at(i, j) == expected
+                  && sum.at(i, j) == residue(std::int64_t(a[i * n + j]) + b[i * n + j])
+                  && difference.at(i, j) == residue(std::int64_t(a[i * n + j]) - b[i * n + j]);
+        }
+      }
+      CHECK(exact);
+    }
+  }
+
+  ThreadPool::setThreadCount(0);
+}
+
+/**
+  * \brief Tests for exact products reconstructed from residues
+  */
+TEST_CASE("ExactSquareMatrix product tests", "[exactmatrix]"){
+
+  ConcreteSquareMatrix small{"[[1,-2][3,4]]"};
+  ExactSquareMatrix squared = ExactSquareMatrix::product(small, small);
+  CHECK(squared.toString() == "[[-5,-10][15,10]]");
+  CHECK(squared == ExactSquareMatrix{ConcreteSquareMatrix{"[[-5,-10][15,10]]"}});
+  CHECK(ExactSquareMatrix::product(ConcreteSquareMatrix{2}, small) == ExactSquareMatrix{2});
+  CHECK_THROWS(ExactSquareMatrix::product(small, ConcreteSquareMatrix{3}));
+  CHECK_THROWS(squared.at(0, 2));
+
+  // Extreme values need every prime
+  ConcreteSquareMatrix extreme{"[[-2147483648,-2147483648][-2147483648,-2147483648]]"};
+  ExactSquareMatrix big = ExactSquareMatrix::product(extreme, extreme);
+  CHECK(big.at(1, 0) == WideInt(2) * (WideInt(1) << 62));
+  CHECK(big.toString() == "[[9223372036854775808,9223372036854775808][9223372036854775808,9223372036854775808]]");
+
+  const std::size_t n = 70;
+  std::vector<int> a(n * n);
+  std::vector<int> b(n * n);
+  for(std::size_t i = 0; i < n * n; i++){
+    a[i] = int(i * 2654435761u);
+    b[i] = i % 7 == 0 ? -2147483647 - 1 : int(i * 40503u * 97u);
+  }
+  a[5] = 2147483647;
+
+  std::stringstream sa;
+  std::stringstream sb;
+  sa << '[';
+  sb << '[';
+  for(std::size_t i = 0; i < n; i++){
+    sa << '[';
+    sb << '[';
+    for(std::size_t j = 0; j < n; j++){
+      sa << (j != 0 ? "," : "") << a[i * n + j];
+      sb << (j != 0 ? "," : "") << b[i * n + j];
+    }
+    sa << ']';
+    sb << ']';
+  }
+  sa << ']';
+  sb << ']';
+
+  ConcreteSquareMatrix ca{sa.str()};
+  ConcreteSquareMatrix cb{sb.str()};
+
+  for(unsigned int threads : {1, 4}){
+    ThreadPool::setThreadCount(threads);
+    ExactSquareMatrix product = ExactSquareMatrix::product(ca, cb);
+
+    bool exact = true;
+    for(std::size_t i = 0; i < n; i++){
+      for(std::size_t j = 0; j < n; j++){
+        WideInt expected = 0;
+        for(std::size_t k = 0; k < n; k++){
+          expected += WideInt(a[i * n + k]) * b[k * n + j];
+        }
+        exact = exact && product.at(i, j) == expected;
+      }
+    }
+    CHECK(exact);
+
+    // Low bits agree with wrapping int arithmetic
+    CHECK(product.toConcrete() == ca * cb);
+  }
+
+  ThreadPool::setThreadCount(0);
+}
+
+/**
+  * \brief Tests for elementwise add and subtract kernels on every instruction set
+  */
+TEST_CASE("Elementwise kernel tests", "[concretematrix]"){
+
+  const std::size_t count = 67; // Leaves a tail for every vector width
+  std::vector<int> a(count);
+  std::vector<int> b(count);
+  std::vector<int> expectedSum(count);
+  std::vector<int> expectedDifference(count);
+
+  for(std::size_t i = 0; i < count; i++){
+    a[i] = int(i * 2654435761u);
+    b[i] = int(i * 40503u) - 20000;
+    expectedSum[i] = int(unsigned(a[i]) + unsigned(b[i]));
+    expectedDifference[i] = int(unsigned(a[i]) - unsigned(b[i]));
+  }
+
+  for(SimdLevel level : {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2, SimdLevel::Avx512}){
+
+    std::vector<int> sum(count);
+    std::vector<int> difference(a);
+
+    addInts(a.data(), b.data(), sum.data(), count, level);
+    subtractInts(difference.data(), b.data(), difference.data(), count, level);
+
+    CHECK(sum == expectedSum);
+    CHECK(difference == expectedDifference);
+  }
+}
+
+/**
+  * \brief Tests for ThreadPool and parallel concrete arithmetic
+  */
+TEST_CASE("ThreadPool and parallel arithmetic tests", "[concretematrix]"){
+
+  ThreadPool pool{4};
+  std::vector<int> runs(1000, 0);
+
+  // Every task runs exactly once
+  pool.parallelFor(runs.size(), [&](std::size_t i){ runs[i]++; });
+  CHECK(std::count(runs.begin(), runs.end(), 1) == 1000);
+
+  CHECK_THROWS(pool.parallelFor(10, [](std::size_t i){
+    if(i == 7)
+      throw std::runtime_error{"task failed"};
+  }));
+
+  const std::size_t n = 700;
+  std::vector<int> a(n * n);
+  std::vector<int> b(n * n);
+  std::vector<int> serial(n * n, 0);
+  std::vector<int> parallel(n * n, 0);
+
+  for(std::size_t i = 0; i < n * n; i++){
+    a[i] = int(i * 2654435761u);
+    b[i] = int(i % 1000) - 500;
+  }
+
+  gemm(n, n, n, a.data(), n, b.data(), n, serial.data(), n);
+
+  // Result does not depend on number of threads
+  ThreadPool::setThreadCount(4);
+  parallelGemm(n, n, n, a.data(), n, b.data(), n, parallel.data(), n);
+  CHECK(parallel == serial);
+
+  ConcreteSquareMatrix big{1200};
+  big += big;
+  CHECK(big == ConcreteSquareMatrix{1200});
+
+  ThreadPool::setThreadCount(0);
+}
+
 /**
   * \brief Tests for ConcreteSquareMatrix comparison operator overload
   */
@@ -169,6 +724,15 @@ TEST_CASE("ConcreteSquareMatrix comparison operator overload tests", "[concretem
   CHECK(one == one);
   CHECK_FALSE(empty == one);
   CHECK_FALSE(one == two);
+
+  ConcreteSquareMatrix copy{one.toString()};
+  CHECK(one == copy);
+  CHECK(one.hash() == copy.hash());
+  CHECK(one.hash() != two.hash());
+  CHECK(empty.hash() != ConcreteSquareMatrix{"[[0]]"}.hash());
+
+  std::unordered_set<ConcreteSquareMatrix> unique{one, two, copy, one.transpose().transpose()};
+  CHECK(unique.size() == 2);
 }
 
 /**
@@ -224,6 +788,98 @@ TEST_CASE("ConcreteSquareMatrix matrixIntoVector and emptyMatrixIntoVector tests
 
 
 
+/**
+  * \brief Tests for single pass matrix text parser
+  */
+TEST_CASE("Matrix parser tests", "[concretematrix]"){
+
+  CHECK(firstRowLength("[[1,2,3][4,5,6][7,8,9]]") == 3);
+  CHECK(firstRowLength(" [ [ 1 ] ] ") == 1);
+  CHECK(firstRowLength("[[1,2,3") == 0);
+  CHECK(firstRowLength("[1,2]") == 0);
+  CHECK(firstRowLength("[[,,,,,,,,,,]]") == 0);
+
+  // Whitespace and '+' are accepted like with operator>>
+  CHECK(ConcreteSquareMatrix{" [ [ +1 , -2 ]\n[ 3,\t4 ] ] "}.toString() == "[[1,-2][3,4]]");
+  CHECK(ConcreteSquareMatrix{"[[-2147483648]]"}.toString() == "[[-2147483648]]");
+  CHECK_THROWS(ConcreteSquareMatrix{"[[2147483648]]"});
+  CHECK_THROWS(ConcreteSquareMatrix{"[[+-1]]"});
+  CHECK_THROWS(ConcreteSquareMatrix{"[[- 1]]"});
+  CHECK(SymbolicSquareMatrix{"[[ x ,-y][+3, 4]]"}.toString() == "[[x,y][3,4]]");
+  CHECK_THROWS(SymbolicSquareMatrix{"[[x1]]"});
+  CHECK_THROWS(SymbolicSquareMatrix{"[[--x]]"});
+
+  ConcreteSquareMatrix concrete{};
+  CHECK(concrete.isSquareMatrix("[[1,2][3,4]]"));
+  CHECK_FALSE(concrete.isSquareMatrix("[[1,2][3]]"));
+  CHECK_FALSE(concrete.isSquareMatrix("[[x]]"));
+  CHECK_THROWS(concrete.matrixIntoVector("[[1,2][3]]"));
+
+  SymbolicSquareMatrix symbolic{};
+  CHECK(symbolic.isSquareMatrix("[[x,2][3,y]]"));
+  CHECK_FALSE(symbolic.isSquareMatrix("[[x,2]]"));
+
+  std::size_t cells = 0;
+  CHECK(parseSquareMatrix("[[1,a][b,4]]", 2, true, [&](std::size_t i, const MatrixCell& cell){
+    CHECK(i == cells++);
+    CHECK((cell.variable != '\0') == (i == 1 || i == 2));
+  }));
+  CHECK(cells == 4);
+  CHECK_FALSE(parseSquareMatrix("[[1,2][3,4]]", 3, false, [](std::size_t, const MatrixCell&){}));
+}
+
+/**
+  * \brief Tests for binary matrix files
+  */
+TEST_CASE("ConcreteSquareMatrix save and load tests", "[concretematrix]"){
+
+  const std::string path = "matrixfile_tests.bin";
+
+  ConcreteSquareMatrix matrix{"[[1,-2,3][2147483647,-2147483648,0][7,8,9]]"};
+
+  matrix.save(path);
+  ConcreteSquareMatrix loaded = ConcreteSquareMatrix::load(path);
+  CHECK(loaded == matrix);
+
+  // Mapping is private, changes stay in memory
+  loaded += loaded;
+  CHECK(loaded.toString() == "[[2,-4,6][-2,0,0][14,16,18]]");
+  CHECK(ConcreteSquareMatrix::load(path) == matrix);
+
+  // Copies of mapped matrices are independent
+  ConcreteSquareMatrix copy{ConcreteSquareMatrix::load(path)};
+  copy = copy * copy;
+  CHECK(copy == matrix * matrix);
+
+  ConcreteSquareMatrix{}.save(path);
+  CHECK(ConcreteSquareMatrix::load(path).toString() == "[]");
+
+  // Corrupted payload is detected by checksum
+  matrix.save(path);
+  {
+    std::fstream file{path, std::ios::in | std::ios::out | std::ios::binary};
+    file.seekp(64 + 5);
+    file.put('x');
+  }
+  CHECK_THROWS_AS(ConcreteSquareMatrix::load(path), std::runtime_error);
+  CHECK_NOTHROW(ConcreteSquareMatrix::load(path, false));
+
+  // Truncated file and wrong magic
+  {
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file << "MATCALC";
+  }
+  CHECK_THROWS_AS(ConcreteSquareMatrix::load(path), std::runtime_error);
+  {
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    file << std::string(128, 'x');
+  }
+  CHECK_THROWS_AS(ConcreteSquareMatrix::load(path), std::runtime_error);
+
+  std::remove(path.c_str());
+  CHECK_THROWS_AS(ConcreteSquareMatrix::load(path), std::runtime_error);
+}
+
 /**
   * \brief Tests for SymbolicSquareMatrix constructors
   */
@@ -345,6 +1001,143 @@ TEST_CASE("SymbolicSquareMatrix arithmetic operator overload tests", "[symbolicm
 
   result = three * three;
   CHECK(result.evaluate(map).toString() == "[[6,12,18][6,12,18][6,12,18]]");
+
+  // Numbers are folded and zero or one factors vanish while building
+  CHECK((two * two).toString() == "[[7,10][15,22]]");
+  CHECK((SymbolicSquareMatrix{"[[1,0][0,1]]"} * one).toString() == "[[x,y][a,b]]");
+  CHECK((one - one).toString() == "[[0,0][0,0]]");
+  CHECK((one + two - two).toString() == one.toString());
+  CHECK((SymbolicSquareMatrix{"[[0,x][0,0]]"} * one).toString() == "[[(x*a),(x*b)][0,0]]");
+}
+
+/**
+  * \brief Tests for SymbolicSquareMatrix power by repeated squaring
+  */
+TEST_CASE("SymbolicSquareMatrix pow tests", "[symbolicmatrix]"){
+
+  SymbolicSquareMatrix one{"[[x,y][a,b]]"};
+
+  Valuation map{};
+  map['x'] = 1;
+  map['y'] = 2;
+  map['a'] = 3;
+  map['b'] = 4;
+
+  CHECK(one.pow(0).toString() == "[[1,0][0,1]]");
+  CHECK(one.pow(1) == one);
+  CHECK(one.pow(2).evaluate(map) == (one * one).evaluate(map));
+  CHECK(one.pow(7).evaluate(map) == ConcreteSquareMatrix{"[[1,2][3,4]]"}.pow(7));
+  CHECK(SymbolicSquareMatrix{"[[2,0][0,3]]"}.pow(5).toString() == "[[32,0][0,243]]");
+}
+
+/**
+  * \brief Tests for sharing expressions between SymbolicSquareMatrix elements
+  */
+TEST_CASE("SymbolicSquareMatrix shared expression tests", "[symbolicmatrix]"){
+
+  const std::size_t before = CompositeElement::sharedCount();
+  const std::size_t n = 6;
+
+  std::string text = "[";
+  for(std::size_t i = 0; i < n; i++){
+    text += "[";
+    for(std::size_t j = 0; j < n; j++){
+      if(j != 0)
+        text += ",";
+      text += (i + j) % 3 == 0 ? "x" : std::to_string(i * n + j);
+    }
+    text += "]";
+  }
+  text += "]";
+
+  SymbolicSquareMatrix a{text};
+  SymbolicSquareMatrix product = a * a * a * a;
+
+  // Every product adds at most n - 1 sums and n products per element
+  CHECK(CompositeElement::sharedCount() - before <= 3 * n * n * (2 * n - 1));
+
+  // Identical products are not created twice
+  const std::size_t shared = CompositeElement::sharedCount();
+  SymbolicSquareMatrix again = a * a;
+  CHECK(CompositeElement::sharedCount() == shared);
+
+  Valuation map{};
+  map['x'] = 3;
+  ConcreteSquareMatrix concrete = a.evaluate(map);
+  CHECK(product.evaluate(map) == concrete * concrete * concrete * concrete);
+
+  SymbolicSquareMatrix one{"[[x]]"};
+  SymbolicSquareMatrix two{"[[2]]"};
+  CHECK((one * two).evaluate(map).toString() == "[[6]]");
+}
+
+/**
+  * \brief Tests for products of SymbolicSquareMatrices made of dot products
+  */
+TEST_CASE("SymbolicSquareMatrix dot product tests", "[symbolicmatrix]"){
+
+  SymbolicSquareMatrix a{"[[x,2,0][1,y,3][z,0,1]]"};
+  SymbolicSquareMatrix b{"[[y,1,4][0,x,1][2,z,y]]"};
+
+  // Every cell equals the chain of composites built term by term
+  std::vector<std::vector<std::unique_ptr<Element>>> chains = a.matrixIntoVector(a.toString());
+  std::vector<std::vector<std::unique_ptr<Element>>> right = b.matrixIntoVector(b.toString());
+  std::vector<std::vector<std::unique_ptr<Element>>> cells = a.emptyMatrixIntoVector(3);
+  for(std::size_t i = 0; i < 3; i++){
+    for(std::size_t j = 0; j < 3; j++){
+      std::shared_ptr<const Element> sum = ElementBuilder::constant(0);
+      for(std::size_t k = 0; k < 3; k++){
+        sum = ElementBuilder::add(sum, ElementBuilder::multiply(std::shared_ptr<const Element>{chains[i][k]->clone()},
+                                                                std::shared_ptr<const Element>{right[k][j]->clone()}));
+      }
+      cells[i][j] = std::unique_ptr<Element>{sum->clone()};
+    }
+  }
+  const SymbolicSquareMatrix expected{std::move(cells)};
+  const SymbolicSquareMatrix product = a * b;
+
+  CHECK(product == expected);
+  CHECK(product.toString() == expected.toString());
+  CHECK(product.toString().rfind("[[(x*y),(x+(2*x)),((x*4)+2)]", 0) == 0);
+
+  // Products of products reference dot products, and compile and expand like them
+  SymbolicSquareMatrix nested = product * a * b;
+  CompiledSquareMatrix compiled{nested};
+  Valuation map{};
+  map['x'] = 5;
+  map['y'] = -2;
+  map['z'] = 7;
+  const ConcreteSquareMatrix concrete = a.evaluate(map) * b.evaluate(map) * a.evaluate(map) * b.evaluate(map);
+  CHECK(nested.evaluate(map) == concrete);
+  CHECK(compiled.evaluate(map) == concrete);
+  CHECK(nested.evaluate(ValuationBatch{std::vector<Valuation>{map, map}})[1] == concrete);
+  CHECK(nested.toPolynomial() == (a.toPolynomial() * b.toPolynomial() * a.toPolynomial() * b.toPolynomial()));
+}
+
+/**
+  * \brief Tests for SymbolicSquareMatrix with polynomial elements
+  */
+TEST_CASE("SymbolicSquareMatrix polynomial tests", "[symbolicmatrix]"){
+
+  SymbolicSquareMatrix m{"[[x,y][1,x]]"};
+  SymbolicSquareMatrix poly = m.toPolynomial();
+
+  CHECK(poly.toString() == "[[{x},{y}][{1},{x}]]");
+  CHECK((poly * poly).toString() == "[[{x^2+y},{2*x*y}][{2*x},{x^2+y}]]");
+
+  Valuation map{};
+  map['x'] = 2;
+  map['y'] = -3;
+
+  // Same values as tree elements, for any number of multiplications
+  SymbolicSquareMatrix tree = m;
+  SymbolicSquareMatrix canonical = poly;
+  for(int i = 0; i < 6; i++){
+    tree = tree * m;
+    canonical = canonical * poly;
+  }
+  CHECK(canonical.evaluate(map) == tree.evaluate(map));
+  CHECK(tree.toPolynomial() == canonical);
 }
 
 /**
@@ -360,6 +1153,17 @@ TEST_CASE("SymbolicSquareMatrix comparison operator overload tests", "[symbolicm
   CHECK(one == one);
   CHECK_FALSE(empty == one);
   CHECK_FALSE(one == two);
+
+  // Products built separately are equal by structure
+  SymbolicSquareMatrix product = one * two;
+  SymbolicSquareMatrix other = SymbolicSquareMatrix{"[[a,A][B,C]]"} * SymbolicSquareMatrix{"[[b,D][x,C]]"};
+  CHECK(product == other);
+  CHECK(product.hash() == other.hash());
+  CHECK_FALSE(product == two * one);
+  CHECK(product.hash() != (two * one).hash());
+
+  std::unordered_set<SymbolicSquareMatrix> unique{one, two, product, other};
+  CHECK(unique.size() == 3);
 }
 
 /**
@@ -397,6 +1201,133 @@ TEST_CASE("SymbolicSquareMatrix evaluate tests", "[symbolicmatrix]"){
   CHECK(result.toString() == "[[1,2][3,4]]");
 }
 
+/**
+  * \brief Tests for evaluating SymbolicSquareMatrix through CompiledSquareMatrix
+  */
+TEST_CASE("CompiledSquareMatrix evaluate tests", "[symbolicmatrix]"){
+
+  SymbolicSquareMatrix one{"[[x,y,2][a,b,x][1,y,3]]"};
+  SymbolicSquareMatrix product = one * one - one;
+  CompiledSquareMatrix compiled{product};
+
+  for(int x = -2; x < 3; x++){
+    Valuation map{};
+    map['x'] = x;
+    map['y'] = 2 * x;
+    map['a'] = 7;
+    map['b'] = x * x;
+
+    CHECK(compiled.evaluate(map) == product.evaluate(map));
+  }
+
+  Valuation missing{};
+  missing['x'] = 1;
+  CHECK_THROWS(compiled.evaluate(missing));
+
+  CompiledSquareMatrix empty{SymbolicSquareMatrix{}};
+  CHECK(empty.evaluate(missing).toString() == "[]");
+}
+
+/**
+  * \brief Tests for evaluating SymbolicSquareMatrix against a batch of valuations
+  */
+TEST_CASE("SymbolicSquareMatrix batch evaluate tests", "[symbolicmatrix]"){
+
+  SymbolicSquareMatrix one{"[[x,y,2][a,b,x][1,y,3]]"};
+  SymbolicSquareMatrix product = one * one - one + one.transpose();
+
+  // More valuations than one block of lanes, and a partial block
+  std::vector<Valuation> vals;
+  for(int i = 0; i < 150; i++){
+    Valuation map{};
+    map['x'] = i;
+    map['y'] = 1000 - 7 * i;
+    map['a'] = i * i;
+    map['b'] = -i;
+    vals.push_back(map);
+  }
+
+  std::vector<ConcreteSquareMatrix> results = product.evaluate(ValuationBatch{vals});
+
+  REQUIRE(results.size() == vals.size());
+  bool same = true;
+  for(std::size_t i = 0; i < vals.size(); i++){
+    same = same && results[i] == product.evaluate(vals[i]);
+  }
+  CHECK(same);
+
+  // Variable missing from one valuation
+  vals[42].erase('b');
+  CHECK_THROWS_AS(product.evaluate(ValuationBatch{vals}), std::out_of_range);
+
+  ValuationBatch batch{2};
+  CHECK_THROWS(batch.set('1', 0, 5));
+  CHECK_THROWS(batch.set('x', 2, 5));
+  batch.set('x', 0, 5);
+  batch.set('x', 1, 6);
+  std::vector<ConcreteSquareMatrix> xs = SymbolicSquareMatrix{"[[x]]"}.evaluate(batch);
+  CHECK(xs[0].toString() == "[[5]]");
+  CHECK(xs[1].toString() == "[[6]]");
+  CHECK(SymbolicSquareMatrix{"[[x]]"}.evaluate(ValuationBatch{0}).empty());
+}
+
+/**
+  * \brief Tests for matrix-level symbolic expressions evaluated with concrete operations
+  */
+TEST_CASE("SymbolicExpression tests", "[symbolicmatrix]"){
+
+  SymbolicSquareMatrix one{"[[x,y,2][a,b,x][1,y,3]]"};
+  SymbolicSquareMatrix two{"[[1,x,0][y,-4,b][a,2,x]]"};
+  SymbolicExpression a = lazy(one);
+  SymbolicExpression b = lazy(two);
+
+  // Shared subexpression ab is evaluated once and moved to its last user
+  SymbolicExpression ab = a * b;
+  SymbolicExpression e = ab * ab - a + ab;
+  SymbolicSquareMatrix expanded = (one * two) * (one * two) - one + one * two;
+
+  CHECK(e.size() == 3);
+  CHECK(e.operation() == SymbolicExpression::Operation::Add);
+  CHECK(a.operation() == SymbolicExpression::Operation::Leaf);
+  CHECK(e.expand() == expanded);
+  CHECK(e.toString() == expanded.toString());
+
+  std::vector<Valuation> vals;
+  for(int i = -3; i < 4; i++){
+    Valuation map{};
+    map['x'] = i;
+    map['y'] = 100 - 7 * i;
+    map['a'] = i * i;
+    map['b'] = 65536 * i;
+    vals.push_back(map);
+  }
+
+  // Values wrap like symbolic evaluation does
+  bool same = true;
+  for(const Valuation& map : vals){
+    same = same && e.evaluate(map) == expanded.evaluate(map);
+  }
+  CHECK(same);
+
+  std::vector<ConcreteSquareMatrix> results = e.evaluate(ValuationBatch{vals});
+  REQUIRE(results.size() == vals.size());
+  same = true;
+  for(std::size_t i = 0; i < vals.size(); i++){
+    same = same && results[i] == expanded.evaluate(vals[i]);
+  }
+  CHECK(same);
+
+  Valuation missing{};
+  missing['x'] = 1;
+  CHECK_THROWS_AS(e.evaluate(missing), std::out_of_range);
+  CHECK_THROWS_AS(a + lazy(SymbolicSquareMatrix{"[[x]]"}), std::invalid_argument);
+  CHECK((lazy(SymbolicSquareMatrix{}) * lazy(SymbolicSquareMatrix{})).evaluate(missing).toString() == "[]");
+
+  std::stringstream ss;
+  ss << lazy(SymbolicSquareMatrix{"[[x]]"}) * lazy(SymbolicSquareMatrix{"[[2]]"});
+  CHECK(ss.str() == "[[(x*2)]]");
+}
+
 /**
   * \brief Tests for SymbolicSquareMatrix checkOperands function
   */
@@ -428,4 +1359,85 @@ TEST_CASE("SymbolicSquareMatrix matrixIntoVector and emptyMatrixIntoVector tests
   v = emptyMatrix.emptyMatrixIntoVector(2);
   SymbolicSquareMatrix emptyVector{std::move(v)};
   CHECK(emptyVector.toString() == "[[x,x][x,x]]");
-}
\ No newline at end of file
+
+  // Rows of wrong length and missing elements are rejected
+  v = matrix.matrixIntoVector("[[1,2][3,4]]");
+  v[1].pop_back();
+  CHECK_THROWS(SymbolicSquareMatrix{std::move(v)});
+  v = matrix.matrixIntoVector("[[1,2][3,4]]");
+  v[0][1].reset();
+  CHECK_THROWS(SymbolicSquareMatrix{std::move(v)});
+}
+
+/**
+  * \brief Tests for rvalue operators, which compute into the storage of their left operand
+  */
+TEST_CASE("ElementarySquareMatrix rvalue operator tests", "[concretematrix][symbolicmatrix]"){
+
+  ConcreteSquareMatrix a{"[[1,2][3,4]]"};
+  ConcreteSquareMatrix b{"[[5,6][7,8]]"};
+
+  CHECK((ConcreteSquareMatrix{a} + b) == a + b);
+  CHECK((ConcreteSquareMatrix{a} - b) == a - b);
+  CHECK((ConcreteSquareMatrix{a} * b) == a * b);
+  CHECK((a + b) * a == ConcreteSquareMatrix{"[[30,44][46,68]]"});
+  CHECK_THROWS(ConcreteSquareMatrix{a} + ConcreteSquareMatrix{"[[1]]"});
+
+  SymbolicSquareMatrix s{"[[x,2][3,y]]"};
+  SymbolicSquareMatrix t{"[[1,y][x,0]]"};
+
+  CHECK((SymbolicSquareMatrix{s} + t) == s + t);
+  CHECK((SymbolicSquareMatrix{s} - t) == s - t);
+  CHECK((SymbolicSquareMatrix{s} * t) == s * t);
+  CHECK((SymbolicSquareMatrix{s} * s).toString() == (s * s).toString());
+  CHECK_THROWS(SymbolicSquareMatrix{s} * SymbolicSquareMatrix{"[[1]]"});
+
+  // Self as both operands
+  SymbolicSquareMatrix u{s};
+  u = std::move(u) * u;
+  CHECK(u == s * s);
+  u = std::move(u) + u;
+  CHECK(u == (s * s) + (s * s));
+}
+
+/**
+  * \brief Tests for Calculator
+  */
+TEST_CASE("Calculator tests", "[calculator]"){
+
+  Calculator calculator{};
+  CHECK(calculator.empty());
+  CHECK_THROWS(calculator.apply('+'));
+  CHECK_THROWS(calculator.power(2));
+  CHECK_THROWS(calculator.top());
+
+  calculator.push(SymbolicSquareMatrix{"[[x]]"});
+  calculator.push(SymbolicSquareMatrix{"[[x,2][3,y]]"});
+  calculator.push(SymbolicSquareMatrix{"[[1,y][x,0]]"});
+  CHECK(calculator.size() == 3);
+  CHECK(calculator.top(1).toString() == "[[x,2][3,y]]");
+  CHECK(calculator.top().toString() == "[[1,y][x,0]]");
+  CHECK_THROWS(calculator.top(3));
+  CHECK_THROWS(calculator.apply('/'));
+
+  calculator.apply('*');
+  calculator.push(SymbolicSquareMatrix{"[[x,2][3,y]]"});
+  calculator.apply('-');
+  calculator.push(SymbolicSquareMatrix{"[[1,0][0,1]]"});
+  calculator.apply('+');
+  CHECK(calculator.size() == 2);
+
+  SymbolicSquareMatrix s{"[[x,2][3,y]]"};
+  SymbolicSquareMatrix t{"[[1,y][x,0]]"};
+  SymbolicSquareMatrix result = (s * t - s) + SymbolicSquareMatrix{"[[1,0][0,1]]"};
+  CHECK(calculator.top() == result);
+
+  calculator.power(2);
+  CHECK(calculator.top() == result.pow(2));
+
+  // Failed operations leave the stack unchanged
+  CHECK_THROWS(calculator.apply('+'));
+  CHECK(calculator.size() == 2);
+  CHECK(calculator.top() == result.pow(2));
+  CHECK(calculator.top(1).toString() == "[[x]]");
+}
@@ -0,0 +1,156 @@
+/**
+  * \file elementbuilder.cpp
+  * \brief ElementBuilder class
+  */
+
+#include <cstdint>
+#include <vector>
+#include "elementbuilder.h"
+#include "polynomialelement.h"
+
+namespace{
+
+  const IntElement* asInt(const std::shared_ptr<const Element>& e){
+    return dynamic_cast<const IntElement*>(e.get());
+  }
+
+  bool isConstant(const IntElement* i, int value){
+    return i != nullptr && i->getVal() == value;
+  }
+
+  /**
+    * \brief Returns e as composite if it is one with operation opc, else nullptr
+    */
+  const CompositeElement* asComposite(const std::shared_ptr<const Element>& e, char opc){
+    const CompositeElement* c = dynamic_cast<const CompositeElement*>(e.get());
+    return c != nullptr && c->operation() == opc ? c : nullptr;
+  }
+
+  bool same(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2){
+    return e1 == e2 || *e1 == *e2;
+  }
+
+  /**
+    * \brief Applies polynomial operation if either operand is a polynomial, converting the other one
+    */
+  template <typename Operation>
+  std::shared_ptr<const Element> polynomial(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2, Operation op){
+
+    const PolynomialElement* p1 = dynamic_cast<const PolynomialElement*>(e1.get());
+    const PolynomialElement* p2 = dynamic_cast<const PolynomialElement*>(e2.get());
+
+    if(p1 == nullptr && p2 == nullptr)
+      return nullptr;
+    if(p1 == nullptr)
+      return std::make_shared<const PolynomialElement>(op(PolynomialElement::of(*e1), *p2));
+    if(p2 == nullptr)
+      return std::make_shared<const PolynomialElement>(op(*p1, PolynomialElement::of(*e2)));
+    return std::make_shared<const PolynomialElement>(op(*p1, *p2));
+  }
+
+  // Folding wraps like evaluation does
+  int wrap(std::uint32_t value){
+    return int(value);
+  }
+
+}
+
+std::shared_ptr<const Element> ElementBuilder::constant(int value){
+
+  return std::make_shared<const IntElement>(value);
+}
+
+std::shared_ptr<const Element> ElementBuilder::variable(char name){
+
+  // Variables are immutable leaves, so one element per letter is created on first use
+  static const std::vector<std::shared_ptr<const Element>> letters = []{
+    std::vector<std::shared_ptr<const Element>> v(128);
+    for(char c = 'A'; c <= 'Z'; c++)
+      v[c] = std::make_shared<const VariableElement>(c);
+    for(char c = 'a'; c <= 'z'; c++)
+      v[c] = std::make_shared<const VariableElement>(c);
+    return v;
+  }();
+
+  const unsigned char index = static_cast<unsigned char>(name);
+  if(index < letters.size() && letters[index])
+    return letters[index];
+
+  return std::make_shared<const VariableElement>(name);
+}
+
+std::shared_ptr<const Element> ElementBuilder::add(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2){
+
+  if(std::shared_ptr<const Element> p = polynomial(e1, e2, std::plus<>{}))
+    return p;
+
+  const IntElement* c1 = asInt(e1);
+  const IntElement* c2 = asInt(e2);
+
+  if(c1 != nullptr && c2 != nullptr)
+    return constant(wrap(std::uint32_t(c1->getVal()) + std::uint32_t(c2->getVal())));
+  if(isConstant(c1, 0))
+    return e2;
+  if(isConstant(c2, 0))
+    return e1;
+
+  // (a-b)+b and b+(a-b) are a
+  if(const CompositeElement* d = asComposite(e1, '-')){
+    if(same(d->second(), e2))
+      return d->first();
+  }
+  if(const CompositeElement* d = asComposite(e2, '-')){
+    if(same(d->second(), e1))
+      return d->first();
+  }
+
+  return CompositeElement::make(e1, e2, std::plus<int>{}, '+');
+}
+
+std::shared_ptr<const Element> ElementBuilder::subtract(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2){
+
+  if(std::shared_ptr<const Element> p = polynomial(e1, e2, std::minus<>{}))
+    return p;
+
+  const IntElement* c1 = asInt(e1);
+  const IntElement* c2 = asInt(e2);
+
+  if(c1 != nullptr && c2 != nullptr)
+    return constant(wrap(std::uint32_t(c1->getVal()) - std::uint32_t(c2->getVal())));
+  if(isConstant(c2, 0))
+    return e1;
+  if(same(e1, e2))
+    return constant(0);
+
+  // (a+b)-b is a and (a+b)-a is b
+  if(const CompositeElement* s = asComposite(e1, '+')){
+    if(same(s->second(), e2))
+      return s->first();
+    if(same(s->first(), e2))
+      return s->second();
+  }
+
+  return CompositeElement::make(e1, e2, std::minus<int>{}, '-');
+}
+
+std::shared_ptr<const Element> ElementBuilder::multiply(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2){
+
+  if(std::shared_ptr<const Element> p = polynomial(e1, e2, std::multiplies<>{}))
+    return p;
+
+  const IntElement* c1 = asInt(e1);
+  const IntElement* c2 = asInt(e2);
+
+  if(c1 != nullptr && c2 != nullptr)
+    return constant(wrap(std::uint32_t(c1->getVal()) * std::uint32_t(c2->getVal())));
+  if(isConstant(c1, 0))
+    return e1;
+  if(isConstant(c2, 0))
+    return e2;
+  if(isConstant(c1, 1))
+    return e2;
+  if(isConstant(c2, 1))
+    return e1;
+
+  return CompositeElement::make(e1, e2, std::multiplies<int>{}, '*');
+}
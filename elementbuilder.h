@@ -0,0 +1,63 @@
+/**
+  * \file elementbuilder.h
+  * \brief Header for ElementBuilder class
+  */
+#ifndef ELEMENTBUILDER_H
+#define ELEMENTBUILDER_H
+
+#include <memory>
+#include "compositeelement.h"
+
+/**
+  * \class ElementBuilder
+  * \brief Builds arithmetic on shared Elements, simplifying while building. Constants are folded with
+           wrapping int arithmetic, identities (x+0, x-0, x*1) and annihilators (x*0) are applied, and
+           x-x, (a+b)-b and (a-b)+b cancel. Everything else becomes a hash-consed CompositeElement.
+           Simplified elements evaluate to the same values, except that variables removed from the
+           expression no longer need to be mapped. If either operand is a PolynomialElement, the result
+           is the canonical PolynomialElement computed with polynomial arithmetic.
+  */
+class ElementBuilder
+{
+public:
+  /**
+    * \brief Returns simplified sum of elements
+    * \param e1 First summand
+    * \param e2 Second summand
+    * \return Shared element equal to e1 + e2
+    */
+  static std::shared_ptr<const Element> add(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2);
+
+  /**
+    * \brief Returns simplified difference of elements
+    * \param e1 Element subtracted from
+    * \param e2 Element to be subtracted
+    * \return Shared element equal to e1 - e2
+    */
+  static std::shared_ptr<const Element> subtract(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2);
+
+  /**
+    * \brief Returns simplified product of elements
+    * \param e1 First factor
+    * \param e2 Second factor
+    * \return Shared element equal to e1 * e2
+    */
+  static std::shared_ptr<const Element> multiply(const std::shared_ptr<const Element>& e1, const std::shared_ptr<const Element>& e2);
+
+  /**
+    * \brief Returns shared IntElement
+    * \param value Value of element
+    * \return Shared IntElement holding value
+    */
+  static std::shared_ptr<const Element> constant(int value);
+
+  /**
+    * \brief Returns shared VariableElement. Every variable has one element shared by all callers
+    * \param name Name of variable, throws exception if not A-Z or a-z
+    * \return Shared VariableElement of name
+    */
+  static std::shared_ptr<const Element> variable(char name);
+
+};
+
+#endif // ELEMENTBUILDER_H
@@ -0,0 +1,197 @@
+/**
+  * \file exactmatrix.cpp
+  * \brief ExactSquareMatrix class
+  */
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include "exactmatrix.h"
+#include "modularmatrix.h"
+#include "threadpool.h"
+
+namespace{
+
+  using Wide = unsigned __int128;
+
+  // Largest primes below 2^27. Their product exceeds 2^107, far above twice any exact product value, and
+  // products of their residues are small enough to be summed over whole panels before folding
+  constexpr std::uint32_t primes[] = {134217689u, 134217649u, 134217617u, 134217613u};
+  constexpr std::size_t primeCount = sizeof(primes) / sizeof(primes[0]);
+
+  // Below this many values one thread keeps up with reconstruction
+  constexpr std::size_t parallelValues = std::size_t(1) << 16;
+
+  std::uint64_t magnitude(int v){
+    return v < 0 ? 0 - std::uint64_t(std::int64_t(v)) : std::uint64_t(v);
+  }
+
+  std::uint64_t largestMagnitude(const int* values, std::size_t count){
+
+    std::uint64_t largest = 0;
+    for(std::size_t i = 0; i < count; i++){
+      largest = std::max(largest, magnitude(values[i]));
+    }
+    return largest;
+  }
+
+  std::uint32_t power(const Modulus& mod, std::uint32_t base, std::uint32_t e){
+
+    std::uint32_t result = 1;
+    for(; e != 0; e >>= 1){
+      if(e & 1)
+        result = mod.reduce(std::uint64_t(result) * base);
+      base = mod.reduce(std::uint64_t(base) * base);
+    }
+    return result;
+  }
+
+  std::string wideToString(WideInt v){
+
+    if(v == 0)
+      return "0";
+
+    Wide u = v < 0 ? Wide(0) - Wide(v) : Wide(v);
+    std::string digits;
+    for(; u != 0; u /= 10){
+      digits.push_back(char('0' + int(u % 10)));
+    }
+    if(v < 0)
+      digits.push_back('-');
+
+    return std::string(digits.rbegin(), digits.rend());
+  }
+
+}
+
+ExactSquareMatrix::ExactSquareMatrix(unsigned int length) : n{length}, values(std::size_t(length) * length){}
+
+ExactSquareMatrix::ExactSquareMatrix(const ConcreteSquareMatrix& m) : n{m.n}, values(m.elements.data(), m.elements.data() + m.elements.size()){}
+
+ExactSquareMatrix ExactSquareMatrix::product(const ConcreteSquareMatrix& a, const ConcreteSquareMatrix& b){
+
+  a.checkOperands(b);
+
+  const std::size_t size = a.n;
+  const std::size_t count = size * size;
+
+  // Values lie in [-bound, bound], so primes whose product exceeds 2 * bound determine them
+  const Wide bound = Wide(size) * largestMagnitude(a.elements.data(), count) * largestMagnitude(b.elements.data(), count);
+
+  std::vector<Modulus> moduli;
+  Wide range = 1;
+  for(std::size_t i = 0; i < primeCount && (moduli.empty() || range <= 2 * bound); i++){
+    moduli.emplace_back(primes[i]);
+    range *= primes[i];
+  }
+
+  // One prime per thread. With more threads than primes, each product is split across the pool instead
+  std::vector<ModularSquareMatrix> residues(moduli.size(), ModularSquareMatrix{primes[0], 0});
+
+  auto multiply = [&](std::size_t i){
+    const std::uint32_t p = moduli[i].value();
+    residues[i] = ModularSquareMatrix{p, a} * ModularSquareMatrix{p, b};
+  };
+
+  ThreadPool& pool = ThreadPool::shared();
+  if(pool.size() == 1 || pool.size() > moduli.size()){
+    for(std::size_t i = 0; i < moduli.size(); i++)
+      multiply(i);
+  }
+  else{
+    pool.parallelFor(moduli.size(), multiply);
+  }
+
+  // Garner's mixed radix form: x = d0 + d1 p0 + d2 p0 p1 + ..., where each digit is found mod its own prime
+  // from the inverses of the earlier primes
+  const std::size_t k = moduli.size();
+  std::vector<std::uint32_t> inverses(k * k);
+  for(std::size_t i = 0; i < k; i++){
+    for(std::size_t j = 0; j < i; j++){
+      const Modulus& mod = moduli[i];
+      inverses[i * k + j] = power(mod, mod.reduce(moduli[j].value()), mod.value() - 2);
+    }
+  }
+
+  ExactSquareMatrix result{a.n};
+
+  auto reconstruct = [&](std::size_t begin, std::size_t end){
+    std::uint32_t digits[primeCount];
+    for(std::size_t v = begin; v < end; v++){
+      Wide x = 0;
+      Wide radix = 1;
+      for(std::size_t i = 0; i < k; i++){
+        const Modulus& mod = moduli[i];
+        const std::uint32_t p = mod.value();
+        std::uint32_t t = std::uint32_t(residues[i].elements[v]);
+        for(std::size_t j = 0; j < i; j++){
+          const std::uint32_t d = mod.reduce(digits[j]);
+          t = mod.reduce(std::uint64_t(t >= d ? t - d : t + p - d) * inverses[i * k + j]);
+        }
+        digits[i] = t;
+        x += radix * t;
+        radix *= p;
+      }
+      result.values[v] = x > range / 2 ? -WideInt(range - x) : WideInt(x);
+    }
+  };
+
+  const std::size_t chunks = (count + parallelValues - 1) / parallelValues;
+  if(pool.size() == 1 || chunks <= 1){
+    reconstruct(0, count);
+  }
+  else{
+    pool.parallelFor(chunks, [&](std::size_t c){
+      reconstruct(c * parallelValues, std::min(count, (c + 1) * parallelValues));
+    });
+  }
+
+  return result;
+}
+
+WideInt ExactSquareMatrix::at(unsigned int i, unsigned int j) const{
+
+  if(i >= n || j >= n)
+    throw std::out_of_range{"Index is outside of matrix."};
+
+  return values[std::size_t(i) * n + j];
+}
+
+ConcreteSquareMatrix ExactSquareMatrix::toConcrete() const{
+
+  ConcreteSquareMatrix result{n};
+  int* wrapped = result.elements.data();
+
+  for(std::size_t i = 0; i < values.size(); i++){
+    wrapped[i] = int(std::uint32_t(Wide(values[i])));
+  }
+
+  return result;
+}
+
+std::string ExactSquareMatrix::toString() const{
+
+  std::stringstream ss;
+
+  ss << '[';
+
+  for(std::size_t i = 0; i < n; i++){
+    ss << '[';
+    for(std::size_t j = 0; j < n; j++){
+      if(j != 0)
+        ss << ',';
+      ss << wideToString(values[i * n + j]);
+    }
+    ss << ']';
+  }
+
+  ss << ']';
+
+  return ss.str();
+}
+
+std::ostream& operator<<(std::ostream& os, const ExactSquareMatrix& m){
+
+  m.print(os);
+  return os;
+}
@@ -0,0 +1,109 @@
+/**
+  * \file exactmatrix.h
+  * \brief Header for ExactSquareMatrix class
+  */
+#ifndef EXACTMATRIX_H
+#define EXACTMATRIX_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "elementarymatrix.h"
+
+/**
+  * \brief Signed integer wide enough for exact products of int matrices of any size
+  */
+using WideInt = __int128;
+
+/**
+  * \class ExactSquareMatrix
+  * \brief Square matrix of 128-bit integers holding exact products of ConcreteSquareMatrices, which cannot
+           overflow: every value is a sum of at most 2^32 products of two ints, less than 2^94 in magnitude
+  */
+class ExactSquareMatrix
+{
+public:
+  /**
+    * \brief Constructor for size n zero matrix
+    * \param length Size of matrix
+    */
+  explicit ExactSquareMatrix(unsigned int length);
+
+  /**
+    * \brief Constructor widening values of dense matrix
+    * \param m ConcreteSquareMatrix to be widened
+    */
+  explicit ExactSquareMatrix(const ConcreteSquareMatrix& m);
+
+  /**
+    * \brief Computes exact product without overflow. The product is computed modulo as few primes below 2^27
+             as its largest possible value needs, the primes in parallel on the shared ThreadPool, and every
+             value is reconstructed from its residues by the Chinese Remainder Theorem
+    * \param a ConcreteSquareMatrix to be multiplied
+    * \param b ConcreteSquareMatrix to be multiplied by
+    * \return Exact product. Throws exception if sizes differ
+    */
+  static ExactSquareMatrix product(const ConcreteSquareMatrix& a, const ConcreteSquareMatrix& b);
+
+  /**
+    * \brief Getter for size
+    * \return Number of rows and columns
+    */
+  unsigned int size() const{
+    return n;
+  };
+
+  /**
+    * \brief Returns value in row i and column j. Throws std::out_of_range if either is not below size
+    * \param i Row
+    * \param j Column
+    * \return Value
+    */
+  WideInt at(unsigned int i, unsigned int j) const;
+
+  /**
+    * \brief Converts into ConcreteSquareMatrix, keeping the low 32 bits of every value like int arithmetic
+    * \return ConcreteSquareMatrix of wrapped values
+    */
+  ConcreteSquareMatrix toConcrete() const;
+
+  /**
+    * \brief Operator overload for operator ==
+    * \param m ExactSquareMatrix to be compared to
+    * \return True if matrices are identical, else false
+    */
+  bool operator==(const ExactSquareMatrix& m) const{
+    return n == m.n && values == m.values;
+  };
+
+  /**
+    * \brief Returns matrix in the string format of ConcreteSquareMatrix
+    * \return Matrix in predetermined string format
+    */
+  std::string toString() const;
+
+  /**
+    * \brief Prints toString() to output stream
+    * \param os Output stream
+    */
+  void print(std::ostream& os) const{
+
+    os << toString();
+  };
+
+private:
+  unsigned int n;
+  std::vector<WideInt> values;
+
+};
+
+/**
+  * \brief Operator overload for operator <<
+  * \param os Output stream
+  * \param m ExactSquareMatrix to be printed to output stream
+  * \return Output stream with contents of square matrix printed
+  */
+std::ostream& operator<<(std::ostream& os, const ExactSquareMatrix& m);
+
+#endif // EXACTMATRIX_H
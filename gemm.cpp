@@ -0,0 +1,240 @@
+/**
+  * \file gemm.cpp
+  * \brief Blocked integer matrix multiplication kernel
+  */
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include "gemm.h"
+#include "vectorkernels.h"
+#include "threadpool.h"
+
+namespace{
+
+  // Unsigned arithmetic gives the wrap around of int without undefined behaviour
+  using Word = std::uint32_t;
+
+  // Register tile of the micro-kernel. MR x NR accumulators stay in vector registers
+  constexpr std::size_t MR = 6;
+  constexpr std::size_t NR = 16;
+
+  // Cache blocking: KC x NR panel of b in L1, MC x KC block of a in L2, KC x NC panel of b in L3
+  constexpr std::size_t KC = 256;
+  constexpr std::size_t MC = 96;
+  constexpr std::size_t NC = 4096;
+
+  // Below this many multiply-adds packing costs more than it saves
+  constexpr std::size_t smallProduct = 32 * 32 * 32;
+
+  // Tiles of c computed by one parallel task. Large enough to amortize packing b
+  constexpr std::size_t tileRows = 2 * MC;
+  constexpr std::size_t tileCols = 512;
+
+  // Below this many multiply-adds threads cost more than they save
+  constexpr std::size_t parallelProduct = 128 * 128 * 128;
+
+  /**
+    * \brief Copies mc x kc block of a into MR-row panels, each stored column by column, zero padded
+    */
+  void packA(std::size_t mc, std::size_t kc, const int* a, std::size_t lda, Word* dst){
+
+    for(std::size_t i = 0; i < mc; i += MR){
+      const std::size_t rows = std::min(MR, mc - i);
+      for(std::size_t p = 0; p < kc; p++){
+        for(std::size_t r = 0; r < MR; r++){
+          *dst++ = r < rows ? Word(a[(i + r) * lda + p]) : 0;
+        }
+      }
+    }
+  }
+
+  /**
+    * \brief Copies kc x nc panel of b into NR-column panels, each stored row by row, zero padded
+    */
+  void packB(std::size_t kc, std::size_t nc, const int* b, std::size_t ldb, Word* dst){
+
+    for(std::size_t j = 0; j < nc; j += NR){
+      const std::size_t cols = std::min(NR, nc - j);
+      for(std::size_t p = 0; p < kc; p++){
+        const int* row = b + p * ldb + j;
+        for(std::size_t c = 0; c < NR; c++){
+          *dst++ = c < cols ? Word(row[c]) : 0;
+        }
+      }
+    }
+  }
+
+  using MicroKernel = void (*)(std::size_t, const Word*, const Word*, int*, std::size_t, std::size_t, std::size_t);
+
+  /**
+    * \brief Adds top-left mr x nr part of accumulated tile to c
+    */
+  inline void storeTile(const Word (&tile)[MR][NR], int* c, std::size_t ldc, std::size_t mr, std::size_t nr){
+
+    for(std::size_t r = 0; r < mr; r++){
+      int* row = c + r * ldc;
+      for(std::size_t col = 0; col < nr; col++){
+        row[col] = int(Word(row[col]) + tile[r][col]);
+      }
+    }
+  }
+
+  /**
+    * \brief Multiplies MR x kc panel of a with kc x NR panel of b and adds the top-left mr x nr part to c
+    */
+  void microKernel(std::size_t kc, const Word* a, const Word* b, int* c, std::size_t ldc, std::size_t mr, std::size_t nr){
+
+    Word acc[MR][NR] = {};
+
+    for(std::size_t p = 0; p < kc; p++, a += MR, b += NR){
+      for(std::size_t r = 0; r < MR; r++){
+        const Word ar = a[r];
+        for(std::size_t col = 0; col < NR; col++){
+          acc[r][col] += ar * b[col];
+        }
+      }
+    }
+
+    storeTile(acc, c, ldc, mr, nr);
+  }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+  // Eight lanes of Word in one AVX2 register
+  constexpr std::size_t lanes = 8;
+  typedef Word Lane __attribute__((vector_size(lanes * sizeof(Word))));
+  typedef Word UnalignedLane __attribute__((vector_size(lanes * sizeof(Word)), aligned(alignof(Word))));
+
+  /**
+    * \brief AVX2 version of microKernel keeping the whole MR x NR tile in twelve ymm registers
+    */
+  __attribute__((target("avx2")))
+  void microKernelAvx2(std::size_t kc, const Word* a, const Word* b, int* c, std::size_t ldc, std::size_t mr, std::size_t nr){
+
+    static_assert(NR == 2 * lanes, "AVX2 micro-kernel handles two lanes per row");
+
+    Lane acc[MR][NR / lanes] = {};
+
+    for(std::size_t p = 0; p < kc; p++, a += MR, b += NR){
+      const Lane b0 = *reinterpret_cast<const UnalignedLane*>(b);
+      const Lane b1 = *reinterpret_cast<const UnalignedLane*>(b + lanes);
+#pragma GCC unroll 6
+      for(std::size_t r = 0; r < MR; r++){
+        acc[r][0] += a[r] * b0;
+        acc[r][1] += a[r] * b1;
+      }
+    }
+
+    Word tile[MR][NR];
+    std::memcpy(tile, acc, sizeof(tile));
+    storeTile(tile, c, ldc, mr, nr);
+  }
+
+  /**
+    * \brief Picks the widest micro-kernel the running CPU supports
+    */
+  MicroKernel selectMicroKernel(){
+
+    if(supportedSimdLevel() >= SimdLevel::Avx2)
+      return microKernelAvx2;
+    return microKernel;
+  }
+
+#else
+
+  MicroKernel selectMicroKernel(){
+    return microKernel;
+  }
+
+#endif
+
+  /**
+    * \brief Unblocked i-k-j product for operands too small to be worth packing
+    */
+  void smallGemm(std::size_t m, std::size_t n, std::size_t k, const int* a, std::size_t lda,
+                 const int* b, std::size_t ldb, int* c, std::size_t ldc){
+
+    for(std::size_t i = 0; i < m; i++){
+      int* row = c + i * ldc;
+      for(std::size_t p = 0; p < k; p++){
+        const Word ap = Word(a[i * lda + p]);
+        const int* other = b + p * ldb;
+        for(std::size_t j = 0; j < n; j++){
+          row[j] = int(Word(row[j]) + ap * Word(other[j]));
+        }
+      }
+    }
+  }
+
+}
+
+void gemm(std::size_t m, std::size_t n, std::size_t k,
+          const int* a, std::size_t lda,
+          const int* b, std::size_t ldb,
+          int* c, std::size_t ldc){
+
+  if(m == 0 || n == 0 || k == 0)
+    return;
+
+  if(m * n * k <= smallProduct){
+    smallGemm(m, n, k, a, lda, b, ldb, c, ldc);
+    return;
+  }
+
+  static const MicroKernel kernel = selectMicroKernel();
+
+  // Packing buffers are reused between calls on the same thread
+  thread_local std::vector<Word> packedA;
+  thread_local std::vector<Word> packedB;
+  packedA.resize(MC * KC);
+  packedB.resize(KC * ((std::min(NC, n) + NR - 1) / NR * NR));
+
+  for(std::size_t jc = 0; jc < n; jc += NC){
+    const std::size_t nc = std::min(NC, n - jc);
+
+    for(std::size_t pc = 0; pc < k; pc += KC){
+      const std::size_t kc = std::min(KC, k - pc);
+      packB(kc, nc, b + pc * ldb + jc, ldb, packedB.data());
+
+      for(std::size_t ic = 0; ic < m; ic += MC){
+        const std::size_t mc = std::min(MC, m - ic);
+        packA(mc, kc, a + ic * lda + pc, lda, packedA.data());
+
+        for(std::size_t jr = 0; jr < nc; jr += NR){
+          const std::size_t nr = std::min(NR, nc - jr);
+          for(std::size_t ir = 0; ir < mc; ir += MR){
+            const std::size_t mr = std::min(MR, mc - ir);
+            kernel(kc, packedA.data() + ir * kc, packedB.data() + jr * kc,
+                        c + (ic + ir) * ldc + jc + jr, ldc, mr, nr);
+          }
+        }
+      }
+    }
+  }
+}
+
+void parallelGemm(std::size_t m, std::size_t n, std::size_t k,
+                  const int* a, std::size_t lda,
+                  const int* b, std::size_t ldb,
+                  int* c, std::size_t ldc){
+
+  ThreadPool& pool = ThreadPool::shared();
+
+  if(pool.size() == 1 || m * n * k < parallelProduct){
+    gemm(m, n, k, a, lda, b, ldb, c, ldc);
+    return;
+  }
+
+  const std::size_t rowTiles = (m + tileRows - 1) / tileRows;
+  const std::size_t colTiles = (n + tileCols - 1) / tileCols;
+
+  // Tiles do not overlap, so tasks never write the same value
+  pool.parallelFor(rowTiles * colTiles, [&](std::size_t tile){
+    const std::size_t i = tile / colTiles * tileRows;
+    const std::size_t j = tile % colTiles * tileCols;
+    gemm(std::min(tileRows, m - i), std::min(tileCols, n - j), k,
+         a + i * lda, lda, b + j, ldb, c + i * ldc + j, ldc);
+  });
+}
@@ -0,0 +1,39 @@
+/**
+  * \file gemm.h
+  * \brief Header for blocked integer matrix multiplication kernel
+  */
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+
+/**
+  * \brief Adds product of row-major matrices a (m x k) and b (k x n) to row-major matrix c (m x n).
+           Arithmetic wraps around like int arithmetic on two's complement machines, so the result
+           is identical to summing a[i][p] * b[p][j] in any order. c must not overlap a or b.
+  * \param m Rows of a and c
+  * \param n Columns of b and c
+  * \param k Columns of a and rows of b
+  * \param a Pointer to first value of a
+  * \param lda Distance between rows of a
+  * \param b Pointer to first value of b
+  * \param ldb Distance between rows of b
+  * \param c Pointer to first value of c
+  * \param ldc Distance between rows of c
+  */
+void gemm(std::size_t m, std::size_t n, std::size_t k,
+          const int* a, std::size_t lda,
+          const int* b, std::size_t ldb,
+          int* c, std::size_t ldc);
+
+/**
+  * \brief Same as gemm, but splits c into tiles that are computed in parallel on the shared ThreadPool.
+           Every value of c is computed by one task in the same way as gemm, so the result does not
+           depend on the number of threads
+  */
+void parallelGemm(std::size_t m, std::size_t n, std::size_t k,
+                  const int* a, std::size_t lda,
+                  const int* b, std::size_t ldb,
+                  int* c, std::size_t ldc);
+
+#endif // GEMM_H
@@ -0,0 +1,375 @@
+/**
+  * \file lazymatrix.h
+  * \brief Header for lazily evaluated ConcreteSquareMatrix expressions
+  */
+#ifndef LAZYMATRIX_H
+#define LAZYMATRIX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include "elementarymatrix.h"
+#include "strassen.h"
+#include "threadpool.h"
+
+/**
+  * \class MatrixExpression
+  * \brief Base of lazily evaluated ConcreteSquareMatrix expressions, E being the type of the expression.
+           Operators on expressions only record operands, and converting an expression into
+           ConcreteSquareMatrix evaluates it at once: sums and differences in one fused loop over every value,
+           after which products are accumulated into the same result by strassenGemm. So A + B - C + D makes
+           one pass without temporaries, and A * B + C writes C and adds the product onto it.
+           Operand matrices are referenced, not copied, so expressions must be evaluated while they live
+  */
+template <typename E>
+class MatrixExpression{
+
+public:
+  /**
+    * \brief Returns self as the derived expression
+    * \return Reference to expression
+    */
+  const E& expression() const{
+    return static_cast<const E&>(*this);
+  };
+
+  /**
+    * \brief Evaluates expression into a new matrix
+    * \return ConcreteSquareMatrix of values of expression
+    */
+  ConcreteSquareMatrix evaluate() const;
+
+  /**
+    * \brief Evaluates expression, for assigning it to ConcreteSquareMatrix
+    * \return ConcreteSquareMatrix of values of expression
+    */
+  operator ConcreteSquareMatrix() const{
+    return evaluate();
+  };
+
+};
+
+/**
+  * \class LazyMatrix
+  * \brief Leaf of expression referencing a ConcreteSquareMatrix
+  */
+class LazyMatrix : public MatrixExpression<LazyMatrix>{
+
+public:
+  /**
+    * \brief Whether the expression has values outside of products
+    */
+  static constexpr bool elementwise = true;
+
+  /**
+    * \brief Constructor for LazyMatrix class
+    * \param m ConcreteSquareMatrix to be referenced
+    */
+  explicit LazyMatrix(const ConcreteSquareMatrix& m) : values{m.elements.data()}, n{m.n}{};
+
+  /**
+    * \brief Getter for size of referenced matrix
+    * \return Number of rows and columns
+    */
+  unsigned int size() const{
+    return n;
+  };
+
+  /**
+    * \brief Returns value of referenced matrix
+    * \param i Row-major index of value
+    * \return Value as unsigned, so sums wrap like int arithmetic
+    */
+  std::uint32_t element(std::size_t i) const{
+    return std::uint32_t(values[i]);
+  };
+
+  /**
+    * \brief Getter for values of referenced matrix
+    * \return Pointer to row-major values
+    */
+  const int* data() const{
+    return values;
+  };
+
+  /**
+    * \brief Calls f for every product of expression. A matrix has none
+    */
+  template <typename F>
+  void forEachProduct(bool, F&&) const{}
+
+private:
+  static ConcreteSquareMatrix allocate(unsigned int length){
+    return ConcreteSquareMatrix{length, DenseBuffer::uninitialized(std::size_t(length) * length)};
+  };
+
+  static int* data(ConcreteSquareMatrix& m){
+    return m.elements.data();
+  };
+
+  const int* values;
+  unsigned int n;
+
+  template <typename> friend class MatrixExpression;
+  template <typename, typename> friend class LazyProduct;
+
+};
+
+/**
+  * \brief Starts a lazily evaluated expression
+  * \param m ConcreteSquareMatrix to be referenced
+  * \return Expression of m
+  */
+inline LazyMatrix lazy(const ConcreteSquareMatrix& m){
+  return LazyMatrix{m};
+}
+
+/**
+  * \class LazySum
+  * \brief Sum, or difference if Subtract is true, of two expressions
+  */
+template <typename L, typename R, bool Subtract>
+class LazySum : public MatrixExpression<LazySum<L, R, Subtract>>{
+
+public:
+  /**
+    * \brief Whether the expression has values outside of products, true if either operand has
+    */
+  static constexpr bool elementwise = L::elementwise || R::elementwise;
+
+  /**
+    * \brief Constructor for LazySum class. Throws exception if sizes differ
+    * \param l Left operand
+    * \param r Right operand
+    */
+  LazySum(const L& l, const R& r) : left{l}, right{r}{
+    if(l.size() != r.size())
+      throw std::invalid_argument{"Square matrices are not same size."};
+  };
+
+  /**
+    * \brief Getter for size of expression
+    * \return Number of rows and columns
+    */
+  unsigned int size() const{
+    return left.size();
+  };
+
+  /**
+    * \brief Returns sum or difference of values of operands outside of products
+    * \param i Row-major index of value
+    * \return Value, wrapping on overflow
+    */
+  std::uint32_t element(std::size_t i) const{
+    return Subtract ? left.element(i) - right.element(i) : left.element(i) + right.element(i);
+  };
+
+  /**
+    * \brief Calls f for every product of both operands, negating products of a subtracted right operand
+    * \param negate Whether products are subtracted from the enclosing sum
+    * \param f Function called with product and whether it is subtracted
+    */
+  template <typename F>
+  void forEachProduct(bool negate, F&& f) const{
+    left.forEachProduct(negate, f);
+    right.forEachProduct(Subtract ? !negate : negate, f);
+  };
+
+private:
+  L left;
+  R right;
+
+};
+
+/**
+  * \class LazyProduct
+  * \brief Product of two expressions. Operands that are not plain matrices are evaluated first,
+           and the product is added onto the values of the enclosing sum
+  */
+template <typename L, typename R>
+class LazyProduct : public MatrixExpression<LazyProduct<L, R>>{
+
+public:
+  /**
+    * \brief Whether the expression has values outside of products, a product has none
+    */
+  static constexpr bool elementwise = false;
+
+  /**
+    * \brief Constructor for LazyProduct class. Throws exception if sizes differ
+    * \param l Left operand
+    * \param r Right operand
+    */
+  LazyProduct(const L& l, const R& r) : left{l}, right{r}{
+    if(l.size() != r.size())
+      throw std::invalid_argument{"Square matrices are not same size."};
+  };
+
+  /**
+    * \brief Getter for size of expression
+    * \return Number of rows and columns
+    */
+  unsigned int size() const{
+    return left.size();
+  };
+
+  /**
+    * \brief Returns value outside of products, which is zero as the product is accumulated separately
+    * \return Zero
+    */
+  std::uint32_t element(std::size_t) const{
+    return 0;
+  };
+
+  /**
+    * \brief Calls f with self
+    * \param negate Whether product is subtracted from the enclosing sum
+    * \param f Function called with product and whether it is subtracted
+    */
+  template <typename F>
+  void forEachProduct(bool negate, F&& f) const{
+    f(*this, negate);
+  };
+
+  /**
+    * \brief c += a * b, or c -= a * b if negate is true
+    * \param c Values of result
+    * \param negate Whether product is subtracted
+    */
+  void accumulate(int* c, bool negate) const{
+
+    const std::size_t n = size();
+    ConcreteSquareMatrix leftValues{};
+    ConcreteSquareMatrix rightValues{};
+    const int* a = operand(left, leftValues);
+    const int* b = operand(right, rightValues);
+
+    // Negating one operand costs a pass over it instead of a temporary product
+    if(negate){
+      if(a != LazyMatrix::data(leftValues))
+        leftValues = LazyMatrix::allocate(n);
+      int* negated = LazyMatrix::data(leftValues);
+      for(std::size_t i = 0; i < n * n; i++){
+        negated[i] = int(0 - std::uint32_t(a[i]));
+      }
+      a = negated;
+    }
+
+    strassenGemm(n, n, n, a, n, b, n, c, n);
+  };
+
+private:
+  static const int* operand(const LazyMatrix& e, ConcreteSquareMatrix&){
+    return e.data();
+  };
+
+  template <typename O>
+  static const int* operand(const MatrixExpression<O>& e, ConcreteSquareMatrix& values){
+    values = e.evaluate();
+    return LazyMatrix::data(values);
+  };
+
+  L left;
+  R right;
+
+};
+
+template <typename E>
+ConcreteSquareMatrix MatrixExpression<E>::evaluate() const{
+
+  // Values between inner loops of fixed length, which the compiler vectorizes
+  constexpr std::size_t block = 64;
+  constexpr std::size_t chunk = std::size_t(1) << 16;
+  constexpr std::size_t parallelValues = std::size_t(1) << 20;
+
+  const E& e = expression();
+  const std::size_t count = std::size_t(e.size()) * e.size();
+
+  ConcreteSquareMatrix result = LazyMatrix::allocate(e.size());
+  int* c = LazyMatrix::data(result);
+
+  if constexpr (E::elementwise){
+
+    auto run = [&](std::size_t begin, std::size_t end){
+      std::size_t i = begin;
+      for(; i + block <= end; i += block){
+        for(std::size_t j = 0; j < block; j++){
+          c[i + j] = int(e.element(i + j));
+        }
+      }
+      for(; i < end; i++){
+        c[i] = int(e.element(i));
+      }
+    };
+
+    ThreadPool& pool = ThreadPool::shared();
+    if(pool.size() == 1 || count < parallelValues){
+      run(0, count);
+    }
+    else{
+      pool.parallelFor((count + chunk - 1) / chunk, [&](std::size_t k){
+        run(k * chunk, std::min(count, (k + 1) * chunk));
+      });
+    }
+  }
+  else{
+    std::fill(c, c + count, 0);
+  }
+
+  e.forEachProduct(false, [&](const auto& product, bool negate){
+    product.accumulate(c, negate);
+  });
+
+  return result;
+}
+
+/**
+  * \brief Operator overloads for operators +, - and * for expressions, and for expressions with
+           ConcreteSquareMatrix, which is referenced as LazyMatrix
+  */
+template <typename L, typename R>
+LazySum<L, R, false> operator+(const MatrixExpression<L>& l, const MatrixExpression<R>& r){
+  return {l.expression(), r.expression()};
+}
+
+template <typename L>
+LazySum<L, LazyMatrix, false> operator+(const MatrixExpression<L>& l, const ConcreteSquareMatrix& r){
+  return {l.expression(), LazyMatrix{r}};
+}
+
+template <typename R>
+LazySum<LazyMatrix, R, false> operator+(const ConcreteSquareMatrix& l, const MatrixExpression<R>& r){
+  return {LazyMatrix{l}, r.expression()};
+}
+
+template <typename L, typename R>
+LazySum<L, R, true> operator-(const MatrixExpression<L>& l, const MatrixExpression<R>& r){
+  return {l.expression(), r.expression()};
+}
+
+template <typename L>
+LazySum<L, LazyMatrix, true> operator-(const MatrixExpression<L>& l, const ConcreteSquareMatrix& r){
+  return {l.expression(), LazyMatrix{r}};
+}
+
+template <typename R>
+LazySum<LazyMatrix, R, true> operator-(const ConcreteSquareMatrix& l, const MatrixExpression<R>& r){
+  return {LazyMatrix{l}, r.expression()};
+}
+
+template <typename L, typename R>
+LazyProduct<L, R> operator*(const MatrixExpression<L>& l, const MatrixExpression<R>& r){
+  return {l.expression(), r.expression()};
+}
+
+template <typename L>
+LazyProduct<L, LazyMatrix> operator*(const MatrixExpression<L>& l, const ConcreteSquareMatrix& r){
+  return {l.expression(), LazyMatrix{r}};
+}
+
+template <typename R>
+LazyProduct<LazyMatrix, R> operator*(const ConcreteSquareMatrix& l, const MatrixExpression<R>& r){
+  return {LazyMatrix{l}, r.expression()};
+}
+
+#endif // LAZYMATRIX_H
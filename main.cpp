@@ -4,11 +4,12 @@
   */
 
 #define CATCH_CONFIG_RUNNER
-#include <stack>
+#include <limits>
 #include "catch.hpp"
 #include "element.h"
 #include "compositeelement.h"
 #include "elementarymatrix.h"
+#include "calculator.h"
 
 int main(){
 
@@ -16,7 +17,7 @@ int main(){
   Catch::Session().run();
 
   std::string input = "";
-  std::stack<SymbolicSquareMatrix> matrices;
+  Calculator matrices;
   Valuation map{};
 
   // Instructions
@@ -24,6 +25,7 @@ int main(){
   std::cout << "=======================================================================================================" << std::endl;
   std::cout << "Add matrix: \t\tInput square matrix in format \"[[i11,...,inn]...[in1,...,inn]]\" to add to stack" << std::endl;
   std::cout << "Operations: \t\tInput \'+\', \'-\', or \'*\'' to perform operation using two latest matrices" << std::endl;
+  std::cout << "Power: \t\t\tInput \'^k\' to raise latest matrix to power k. Ex. \"^3\"" << std::endl;
   std::cout << "Valuation: \t\tInput variable = value to map value. Ex. \"x=7\"" << std::endl;
   std::cout << "Values: \t\tInput \"values\" to print out mapped values" << std::endl;
   std::cout << "Result: \t\tInput \'=\'' to print value of latest matrix" << std::endl;
@@ -49,33 +51,12 @@ int main(){
       try{
         if(matrices.size() >= 2){
 
-          SymbolicSquareMatrix one{};
-          SymbolicSquareMatrix two{};
-          SymbolicSquareMatrix result{};
+          // Operands are printed first, as apply consumes them
+          std::string one = matrices.top(1).toString();
+          std::string two = matrices.top().toString();
 
-          if(input == "+"){
-            two = matrices.top();
-            matrices.pop();
-            one = matrices.top();
-            matrices.pop();
-            result = one + two;
-          }
-          else if(input == "-"){
-            two = matrices.top();
-            matrices.pop();
-            one = matrices.top();
-            matrices.pop();
-            result = one - two;
-          }
-          else if(input == "*"){
-            two = matrices.top();
-            matrices.pop();
-            one = matrices.top();
-            matrices.pop();
-            result = one * two;
-          }
+          matrices.apply(c);
           std::cout << "Performed " << one << " "<< input << " " << two << std::endl << std::endl;
-          matrices.emplace(result);
         }
         else{
           throw std::invalid_argument{"At least two matrices of same size needed for operation."};
@@ -87,6 +68,31 @@ int main(){
 
     }
 
+    // Power
+    else if(c == '^'){
+      try{
+        std::string digits = input.substr(1);
+        if(digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos){
+          throw std::invalid_argument{"No exponent"};
+        }
+        unsigned long k = std::stoul(digits);
+        if(k > std::numeric_limits<unsigned int>::max()){
+          throw std::out_of_range{"Exponent too large"};
+        }
+        if(matrices.empty()){
+          std::cout << "No matrices added" << std::endl << std::endl;
+        }
+        else{
+          std::string base = matrices.top().toString();
+          matrices.power(k);
+          std::cout << "Performed " << base << " ^ " << k << std::endl << std::endl;
+        }
+      }
+      catch(std::exception e){
+        std::cout << "The format needs to be \"^k\", ex. \"^3\"" << std::endl << std::endl;
+      }
+    }
+
     // Valuation
     else if(input == "="){
       try{
@@ -110,7 +116,7 @@ int main(){
     // Printing valuation
     else if(input == "values"){
 
-      for(auto& val : map){
+      for(const auto& val : map){
         std::cout << val.first << " = " << val.second << std::endl;
       }
       std::cout << std::endl;
@@ -143,7 +149,7 @@ int main(){
     // Adding matrix
     else{
       try{
-        matrices.emplace(SymbolicSquareMatrix{input});
+        matrices.push(SymbolicSquareMatrix{input});
         std::cout << "Added " << input << std::endl << std::endl;
       }
       catch(std::exception e){
@@ -0,0 +1,198 @@
+/**
+  * \file matrixfile.cpp
+  * \brief Binary matrix files
+  */
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "matrixfile.h"
+
+namespace{
+
+  constexpr char magic[8] = {'M', 'A', 'T', 'C', 'A', 'L', 'C', '\0'};
+  constexpr std::uint32_t intElements = 1;
+  constexpr std::uint32_t byteOrderMark = 0x01020304;
+  constexpr std::uint32_t payloadAlignment = 64;
+
+  /**
+    * \brief Header at the start of every matrix file, layout described in matrixfile.h
+    */
+  struct Header{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t elementType;
+    std::uint32_t byteOrder;
+    std::uint32_t payloadOffset;
+    std::uint64_t dimension;
+    std::uint64_t payloadBytes;
+    std::uint64_t checksum;
+    std::uint8_t reserved[16];
+  };
+
+  static_assert(sizeof(Header) == payloadAlignment, "Payload must follow header at an aligned offset");
+
+  constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87u;
+  constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Fu;
+  constexpr std::uint64_t prime3 = 0x165667B19E3779F9u;
+
+  std::uint64_t rotate(std::uint64_t x, int r){
+    return x << r | x >> (64 - r);
+  }
+
+  std::uint64_t mix(std::uint64_t acc, std::uint64_t word){
+    return rotate(acc + word * prime2, 31) * prime1;
+  }
+
+  std::uint64_t loadWord(const unsigned char* p){
+    std::uint64_t w;
+    std::memcpy(&w, p, sizeof(w));
+    return w;
+  }
+
+  /**
+    * \brief Unmaps mapping unless it was handed over
+    */
+  struct Mapping{
+    void* start;
+    std::size_t bytes;
+
+    ~Mapping(){
+      if(start != nullptr)
+        munmap(start, bytes);
+    }
+
+    void* release(){
+      void* p = start;
+      start = nullptr;
+      return p;
+    }
+  };
+
+  [[noreturn]] void fail(const std::string& path, const std::string& reason){
+    throw std::runtime_error{path + ": " + reason};
+  }
+
+}
+
+std::uint64_t payloadChecksum(const void* data, std::size_t bytes){
+
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  const unsigned char* end = p + bytes;
+
+  std::uint64_t h;
+
+  if(bytes >= 32){
+    std::uint64_t lanes[4] = {prime1 + prime2, prime2, 0, 0 - prime1};
+    for(; end - p >= 32; p += 32){
+      for(int l = 0; l < 4; l++){
+        lanes[l] = mix(lanes[l], loadWord(p + 8 * l));
+      }
+    }
+    h = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+  }
+  else{
+    h = prime3;
+  }
+
+  h += bytes;
+
+  for(; end - p >= 8; p += 8){
+    h = rotate(h ^ mix(0, loadWord(p)), 27) * prime1 + prime3;
+  }
+  for(; p != end; p++){
+    h = rotate(h ^ *p * prime3, 11) * prime1;
+  }
+
+  h ^= h >> 33;
+  h *= prime2;
+  h ^= h >> 29;
+  h *= prime3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+void saveMatrixFile(const std::string& path, std::size_t n, const int* values){
+
+  const std::size_t bytes = n * n * sizeof(int);
+
+  Header header{};
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = matrixFileVersion;
+  header.elementType = intElements;
+  header.byteOrder = byteOrderMark;
+  header.payloadOffset = sizeof(Header);
+  header.dimension = n;
+  header.payloadBytes = bytes;
+  header.checksum = payloadChecksum(values, bytes);
+
+  std::ofstream out{path, std::ios::binary | std::ios::trunc};
+  if(!out)
+    fail(path, "cannot open file for writing");
+
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(values), bytes);
+  out.close();
+
+  if(!out)
+    fail(path, "cannot write file");
+}
+
+DenseBuffer loadMatrixFile(const std::string& path, std::size_t& n, bool verify){
+
+  const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd < 0)
+    fail(path, "cannot open file");
+
+  struct stat info;
+  if(fstat(fd, &info) != 0 || info.st_size < off_t(sizeof(Header))){
+    close(fd);
+    fail(path, "not a matrix file");
+  }
+
+  // Private writable mapping, so values can be changed in place without touching the file
+  const std::size_t fileBytes = std::size_t(info.st_size);
+  void* start = mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if(start == MAP_FAILED)
+    fail(path, "cannot map file");
+
+  Mapping mapping{start, fileBytes};
+
+  Header header;
+  std::memcpy(&header, start, sizeof(header));
+
+  if(std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+    fail(path, "not a matrix file");
+  if(header.byteOrder != byteOrderMark)
+    fail(path, "matrix file was written with a different byte order");
+  if(header.version != matrixFileVersion)
+    fail(path, "unsupported matrix file version " + std::to_string(header.version));
+  if(header.elementType != intElements)
+    fail(path, "unsupported element type");
+
+  const std::uint64_t dim = header.dimension;
+  const std::uint64_t maxValues = std::numeric_limits<std::size_t>::max() / sizeof(int);
+
+  if(dim > std::numeric_limits<unsigned int>::max() || (dim != 0 && dim > maxValues / dim))
+    fail(path, "matrix is too large");
+  if(header.payloadBytes != dim * dim * sizeof(int) || header.payloadOffset % payloadAlignment != 0
+     || header.payloadOffset < sizeof(Header) || header.payloadOffset > fileBytes
+     || header.payloadBytes > fileBytes - header.payloadOffset)
+    fail(path, "matrix file is truncated or corrupt");
+
+  const unsigned char* payload = static_cast<const unsigned char*>(start) + header.payloadOffset;
+  if(verify && payloadChecksum(payload, header.payloadBytes) != header.checksum)
+    fail(path, "checksum does not match");
+
+  n = dim;
+
+  return DenseBuffer::adoptMapping(mapping.release(), fileBytes, header.payloadOffset, dim * dim);
+}
@@ -0,0 +1,61 @@
+/**
+  * \file matrixfile.h
+  * \brief Header for binary matrix files
+  *
+  * A matrix file is a 64 byte header followed by the payload, the values of the matrix in row-major
+  * order. All header fields are in the byte order of the machine that wrote the file.
+  *
+  * | Offset | Size | Field                                                     |
+  * |--------|------|-----------------------------------------------------------|
+  * | 0      | 8    | Magic "MATCALC\0"                                         |
+  * | 8      | 4    | Format version, currently 1                               |
+  * | 12     | 4    | Element type, 1 for 32-bit two's complement ints          |
+  * | 16     | 4    | Byte order mark 0x01020304                                |
+  * | 20     | 4    | Offset of payload, a multiple of 64                       |
+  * | 24     | 8    | Dimension n                                               |
+  * | 32     | 8    | Length of payload in bytes, n * n * 4                     |
+  * | 40     | 8    | Checksum of payload, see payloadChecksum                  |
+  * | 48     | 16   | Reserved, zero                                            |
+  */
+#ifndef MATRIXFILE_H
+#define MATRIXFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "densebuffer.h"
+
+/**
+  * \brief Current version of the matrix file format
+  */
+constexpr std::uint32_t matrixFileVersion = 1;
+
+/**
+  * \brief Computes checksum stored in matrix files. Four interleaved multiply-rotate lanes over 64-bit
+           words, so it runs close to memory speed on multi-gigabyte payloads
+  * \param data First byte
+  * \param bytes Number of bytes
+  * \return Checksum of bytes
+  */
+std::uint64_t payloadChecksum(const void* data, std::size_t bytes);
+
+/**
+  * \brief Writes matrix file. Throws std::runtime_error if file cannot be written
+  * \param path Path of file, replaced if it exists
+  * \param n Dimension of matrix
+  * \param values n * n values in row-major order
+  */
+void saveMatrixFile(const std::string& path, std::size_t n, const int* values);
+
+/**
+  * \brief Maps matrix file into memory privately, so values are used without reading or copying them and
+           changes to them are never written back. Throws std::runtime_error if file cannot be mapped or is
+           not a valid matrix file
+  * \param path Path of file
+  * \param n Dimension of matrix, set by function
+  * \param verify Whether the checksum is checked, which reads the whole payload once
+  * \return Buffer holding n * n values in row-major order
+  */
+DenseBuffer loadMatrixFile(const std::string& path, std::size_t& n, bool verify);
+
+#endif // MATRIXFILE_H
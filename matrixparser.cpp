@@ -0,0 +1,33 @@
+/**
+  * \file matrixparser.cpp
+  * \brief Single pass parser of matrix text
+  */
+
+#include "matrixparser.h"
+
+std::size_t firstRowLength(std::string_view s){
+
+  const char* p = s.data();
+  const char* end = p + s.size();
+
+  for(int bracket = 0; bracket < 2; bracket++){
+    skipSpace(p, end);
+    if(p == end || *p++ != '[')
+      return 0;
+  }
+
+  // Cells are separated by commas, so the row holds one more cell than it has commas
+  std::size_t n = 1;
+  while(p != end && *p != ']'){
+    if(*p++ == ',')
+      n++;
+  }
+  if(p == end)
+    return 0;
+
+  // Every cell takes at least one char
+  if(n > s.size() / n)
+    return 0;
+
+  return n;
+}
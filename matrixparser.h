@@ -0,0 +1,136 @@
+/**
+  * \file matrixparser.h
+  * \brief Header for single pass parser of matrix text "[[a,b][c,d]]"
+  */
+#ifndef MATRIXPARSER_H
+#define MATRIXPARSER_H
+
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+#include <system_error>
+
+/**
+  * \brief Cell read from matrix text, an integer or a variable
+  */
+struct MatrixCell{
+  int value;
+  char variable;  // '\0' for integers
+};
+
+/**
+  * \brief Skips whitespace like operator>> does
+  * \param p Position in text, moved past whitespace
+  * \param end End of text
+  */
+inline void skipSpace(const char*& p, const char* end){
+  while(p != end && (*p == ' ' || (*p >= '\t' && *p <= '\r')))
+    p++;
+}
+
+/**
+  * \brief Reads cell after optional whitespace. Integers may have a sign, variables are A-Z or a-z
+           and a sign before them is ignored
+  * \param p Position in text, moved past cell if one was read
+  * \param end End of text
+  * \param variables Whether variables are accepted
+  * \param cell Cell that was read
+  * \return True if cell was read, else false
+  */
+inline bool readCell(const char*& p, const char* end, bool variables, MatrixCell& cell){
+
+  skipSpace(p, end);
+  if(p == end)
+    return false;
+
+  // from_chars does not accept '+', operator>> does
+  const char* digits = p;
+  if(*digits == '+' && digits + 1 != end && *(digits + 1) >= '0' && *(digits + 1) <= '9')
+    digits++;
+
+  std::from_chars_result r = std::from_chars(digits, end, cell.value);
+  if(r.ec == std::errc{}){
+    cell.variable = '\0';
+    p = r.ptr;
+    return true;
+  }
+  if(r.ec == std::errc::result_out_of_range || !variables)
+    return false;
+
+  // operator>> dropped a failed sign before variables, so "-x" has always meant x
+  const char* name = p;
+  if(*name == '+' || *name == '-'){
+    name++;
+    skipSpace(name, end);
+  }
+
+  if(name != end && ((*name >= 'A' && *name <= 'Z') || (*name >= 'a' && *name <= 'z'))){
+    cell.value = 0;
+    cell.variable = *name;
+    p = name + 1;
+    return true;
+  }
+
+  return false;
+}
+
+/**
+  * \brief Returns size of square matrix text judging by its first row, without validating the rest.
+           Sizes whose cells could not fit in the text are rejected, so the result is safe to allocate for
+  * \param s Matrix text
+  * \return Number of cells in first row, 0 if text does not start with a complete row
+  */
+std::size_t firstRowLength(std::string_view s);
+
+/**
+  * \brief Validates square matrix text of size n and passes its cells to sink in row-major order.
+           Text is scanned once without allocating, whitespace is allowed around brackets, commas and cells
+  * \param s Matrix text
+  * \param n Size of matrix, usually firstRowLength(s)
+  * \param variables Whether cells may be variables A-Z or a-z
+  * \param sink Called as sink(index, cell) for every cell, index = row * n + column
+  * \return True if text is a square matrix of size n, else false. Sink may have been called for some cells
+  */
+template <typename Sink>
+bool parseSquareMatrix(std::string_view s, std::size_t n, bool variables, Sink&& sink){
+
+  const char* p = s.data();
+  const char* end = p + s.size();
+  MatrixCell cell;
+
+  if(n == 0)
+    return false;
+
+  skipSpace(p, end);
+  if(p == end || *p++ != '[')
+    return false;
+
+  for(std::size_t i = 0; i < n; i++){
+
+    skipSpace(p, end);
+    if(p == end || *p++ != '[')
+      return false;
+
+    for(std::size_t j = 0; j < n; j++){
+
+      if(!readCell(p, end, variables, cell))
+        return false;
+
+      sink(i * n + j, cell);
+
+      // Every row ends after exactly n cells
+      skipSpace(p, end);
+      if(p == end || *p++ != (j + 1 < n ? ',' : ']'))
+        return false;
+    }
+  }
+
+  skipSpace(p, end);
+  if(p == end || *p++ != ']')
+    return false;
+
+  skipSpace(p, end);
+  return p == end;
+}
+
+#endif // MATRIXPARSER_H
@@ -0,0 +1,438 @@
+/**
+  * \file modularmatrix.cpp
+  * \brief Modulus and ModularSquareMatrix classes
+  */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "modularmatrix.h"
+#include "matrixparser.h"
+#include "vectorkernels.h"
+#include "threadpool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#endif
+
+namespace{
+
+  using Word = std::uint32_t;
+
+  // Below this many values one thread keeps up with memory
+  constexpr std::size_t parallelValues = std::size_t(1) << 20;
+  constexpr std::size_t chunkValues = std::size_t(1) << 16;
+
+  // Register tile of the micro-kernel and cache blocking, as in gemm. Sums are 64 bits, so tiles are narrower
+  constexpr std::size_t MR = 4;
+  constexpr std::size_t NR = 8;
+  constexpr std::size_t KC = 256;
+  constexpr std::size_t MC = 64;
+  constexpr std::size_t NC = 2048;
+
+  // Tiles of c computed by one parallel task
+  constexpr std::size_t tileRows = 2 * MC;
+  constexpr std::size_t tileCols = 512;
+
+  // Below this many multiply-adds threads cost more than they save
+  constexpr std::size_t parallelProduct = 128 * 128 * 128;
+
+  bool isPrime(std::uint32_t p){
+
+    if(p < 2)
+      return false;
+    if(p % 2 == 0)
+      return p == 2;
+    for(std::uint32_t d = 3; d <= p / d; d += 2){
+      if(p % d == 0)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+    * \brief Runs kernel(begin, count) over count values, in chunks on the shared ThreadPool for large counts
+    */
+  template <typename Kernel>
+  void elementwise(std::size_t count, Kernel kernel){
+
+    ThreadPool& pool = ThreadPool::shared();
+
+    if(pool.size() == 1 || count < parallelValues){
+      kernel(0, count);
+      return;
+    }
+
+    pool.parallelFor((count + chunkValues - 1) / chunkValues, [&](std::size_t chunk){
+      const std::size_t begin = chunk * chunkValues;
+      kernel(begin, std::min(chunkValues, count - begin));
+    });
+  }
+
+  /**
+    * \brief Copies mc x kc block of a into MR-row panels, each stored column by column, zero padded
+    */
+  void packA(std::size_t mc, std::size_t kc, const Word* a, std::size_t lda, Word* dst){
+
+    for(std::size_t i = 0; i < mc; i += MR){
+      const std::size_t rows = std::min(MR, mc - i);
+      for(std::size_t p = 0; p < kc; p++){
+        for(std::size_t r = 0; r < MR; r++){
+          *dst++ = r < rows ? a[(i + r) * lda + p] : 0;
+        }
+      }
+    }
+  }
+
+  /**
+    * \brief Copies kc x nc panel of b into NR-column panels, each stored row by row, zero padded
+    */
+  void packB(std::size_t kc, std::size_t nc, const Word* b, std::size_t ldb, Word* dst){
+
+    for(std::size_t j = 0; j < nc; j += NR){
+      const std::size_t cols = std::min(NR, nc - j);
+      for(std::size_t p = 0; p < kc; p++){
+        const Word* row = b + p * ldb + j;
+        for(std::size_t c = 0; c < NR; c++){
+          *dst++ = c < cols ? row[c] : 0;
+        }
+      }
+    }
+  }
+
+  using MicroKernel = void (*)(const Modulus&, std::size_t, const Word*, const Word*, Word*, std::size_t,
+                               std::size_t, std::size_t);
+
+  /**
+    * \brief Reduces top-left mr x nr part of tile of sums below 2^63 into residues of c
+    */
+  inline void storeTile(const Modulus& mod, const std::uint64_t (&tile)[MR][NR], Word* c, std::size_t ldc,
+                        std::size_t mr, std::size_t nr){
+
+    for(std::size_t r = 0; r < mr; r++){
+      Word* row = c + r * ldc;
+      for(std::size_t col = 0; col < nr; col++){
+        row[col] = mod.reduce(tile[r][col] + row[col]);
+      }
+    }
+  }
+
+  /**
+    * \brief Multiplies MR x kc panel of a with kc x NR panel of b and adds the top-left mr x nr part to c mod p.
+             Sums are folded below 2^63 every lazyProducts() steps, so they never overflow
+    */
+  void microKernel(const Modulus& mod, std::size_t kc, const Word* a, const Word* b, Word* c, std::size_t ldc,
+                   std::size_t mr, std::size_t nr){
+
+    const std::uint64_t fold = mod.foldConstant();
+    std::uint64_t acc[MR][NR] = {};
+
+    for(std::size_t p = 0; p < kc;){
+      const std::size_t steps = std::min(mod.lazyProducts(), kc - p);
+      for(std::size_t s = 0; s < steps; s++, a += MR, b += NR){
+        for(std::size_t r = 0; r < MR; r++){
+          const std::uint64_t ar = a[r];
+          for(std::size_t col = 0; col < NR; col++){
+            acc[r][col] += ar * b[col];
+          }
+        }
+      }
+      for(std::size_t r = 0; r < MR; r++){
+        for(std::size_t col = 0; col < NR; col++){
+          acc[r][col] -= acc[r][col] >> 63 ? fold : 0;
+        }
+      }
+      p += steps;
+    }
+
+    storeTile(mod, acc, c, ldc, mr, nr);
+  }
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+  /**
+    * \brief AVX2 version of microKernel. Each ymm register holds four 64-bit sums, and vpmuludq multiplies
+             the zero extended residues, so the MR x NR tile stays in eight registers
+    */
+  __attribute__((target("avx2")))
+  void microKernelAvx2(const Modulus& mod, std::size_t kc, const Word* a, const Word* b, Word* c, std::size_t ldc,
+                       std::size_t mr, std::size_t nr){
+
+    static_assert(NR == 8, "AVX2 micro-kernel handles two registers of four sums per row");
+
+    const __m256i fold = _mm256_set1_epi64x(std::int64_t(mod.foldConstant()));
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc[MR][2];
+    for(std::size_t r = 0; r < MR; r++){
+      acc[r][0] = zero;
+      acc[r][1] = zero;
+    }
+
+    for(std::size_t p = 0; p < kc;){
+      const std::size_t steps = std::min(mod.lazyProducts(), kc - p);
+      for(std::size_t s = 0; s < steps; s++, a += MR, b += NR){
+        const __m256i b0 = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+        const __m256i b1 = _mm256_cvtepu32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 4)));
+#pragma GCC unroll 4
+        for(std::size_t r = 0; r < MR; r++){
+          const __m256i ar = _mm256_set1_epi64x(a[r]);
+          acc[r][0] = _mm256_add_epi64(acc[r][0], _mm256_mul_epu32(ar, b0));
+          acc[r][1] = _mm256_add_epi64(acc[r][1], _mm256_mul_epu32(ar, b1));
+        }
+      }
+      // Sums of at least 2^63 are negative as signed values
+      for(std::size_t r = 0; r < MR; r++){
+        for(std::size_t h = 0; h < 2; h++){
+          acc[r][h] = _mm256_sub_epi64(acc[r][h], _mm256_and_si256(_mm256_cmpgt_epi64(zero, acc[r][h]), fold));
+        }
+      }
+      p += steps;
+    }
+
+    std::uint64_t tile[MR][NR];
+    std::memcpy(tile, acc, sizeof(tile));
+    storeTile(mod, tile, c, ldc, mr, nr);
+  }
+
+  /**
+    * \brief Picks the widest micro-kernel the running CPU supports
+    */
+  MicroKernel selectMicroKernel(){
+
+    if(supportedSimdLevel() >= SimdLevel::Avx2)
+      return microKernelAvx2;
+    return microKernel;
+  }
+
+#else
+
+  MicroKernel selectMicroKernel(){
+    return microKernel;
+  }
+
+#endif
+
+  /**
+    * \brief c = (c + a * b) mod p for m x k residues of a and k x n residues of b
+    */
+  void modularGemm(const Modulus& mod, std::size_t m, std::size_t n, std::size_t k,
+                   const Word* a, std::size_t lda, const Word* b, std::size_t ldb, Word* c, std::size_t ldc){
+
+    static const MicroKernel kernel = selectMicroKernel();
+
+    // Packing buffers are reused between calls on the same thread
+    thread_local std::vector<Word> packedA;
+    thread_local std::vector<Word> packedB;
+    packedA.resize(MC * KC);
+    packedB.resize(KC * ((std::min(NC, n) + NR - 1) / NR * NR));
+
+    for(std::size_t jc = 0; jc < n; jc += NC){
+      const std::size_t nc = std::min(NC, n - jc);
+
+      for(std::size_t pc = 0; pc < k; pc += KC){
+        const std::size_t kc = std::min(KC, k - pc);
+        packB(kc, nc, b + pc * ldb + jc, ldb, packedB.data());
+
+        for(std::size_t ic = 0; ic < m; ic += MC){
+          const std::size_t mc = std::min(MC, m - ic);
+          packA(mc, kc, a + ic * lda + pc, lda, packedA.data());
+
+          for(std::size_t jr = 0; jr < nc; jr += NR){
+            const std::size_t nr = std::min(NR, nc - jr);
+            for(std::size_t ir = 0; ir < mc; ir += MR){
+              const std::size_t mr = std::min(MR, mc - ir);
+              kernel(mod, kc, packedA.data() + ir * kc, packedB.data() + jr * kc,
+                     c + (ic + ir) * ldc + jc + jr, ldc, mr, nr);
+            }
+          }
+        }
+      }
+    }
+  }
+
+}
+
+Modulus::Modulus(std::uint32_t p) : p{p}{
+
+  if(p >= (Word(1) << 31) || !isPrime(p))
+    throw std::invalid_argument{"Modulus needs to be a prime below 2^31."};
+
+  ratio = std::numeric_limits<std::uint64_t>::max() / p;
+
+  // Sums stay below 2^63 between folds. Lazy products of residues, each at most (p - 1)^2, add at most
+  // 2^63 - p, and folding subtracts more than 2^63 - p from sums of at least 2^63, leaving them below 2^63
+  const std::uint64_t half = std::uint64_t(1) << 63;
+  const std::uint64_t largest = std::max<std::uint64_t>(std::uint64_t(p - 1) * (p - 1), 1);
+  lazy = std::min<std::uint64_t>((half - p) / largest, std::numeric_limits<std::size_t>::max());
+  fold = half / p * p;
+}
+
+ModularSquareMatrix::ModularSquareMatrix(std::uint32_t p, unsigned int length) : mod{p}, n{length}, elements(std::size_t(length) * length){}
+
+ModularSquareMatrix::ModularSquareMatrix(std::uint32_t p, const std::string& str_m) : mod{p}{
+
+  const std::size_t size = firstRowLength(str_m);
+  DenseBuffer cells = DenseBuffer::uninitialized(size * size);
+
+  auto store = [&](std::size_t i, const MatrixCell& cell){
+    cells[i] = int(mod.fromInt(cell.value));
+  };
+
+  if(!parseSquareMatrix(str_m, size, false, store))
+    throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
+
+  n = size;
+  elements = std::move(cells);
+}
+
+ModularSquareMatrix::ModularSquareMatrix(std::uint32_t p, const ConcreteSquareMatrix& m) : mod{p}, n{m.n}{
+
+  elements = DenseBuffer::uninitialized(m.elements.size());
+
+  const int* values = m.elements.data();
+  int* residues = elements.data();
+
+  for(std::size_t i = 0; i < elements.size(); i++){
+    residues[i] = int(mod.fromInt(values[i]));
+  }
+}
+
+std::uint32_t ModularSquareMatrix::at(unsigned int i, unsigned int j) const{
+
+  if(i >= n || j >= n)
+    throw std::out_of_range{"Index is outside of matrix."};
+
+  return Word(elements[std::size_t(i) * n + j]);
+}
+
+ConcreteSquareMatrix ModularSquareMatrix::toConcrete() const{
+
+  return ConcreteSquareMatrix{n, DenseBuffer{elements}};
+}
+
+ModularSquareMatrix& ModularSquareMatrix::operator+=(const ModularSquareMatrix& m){
+
+  checkOperands(m);
+
+  const Word p = mod.value();
+  Word* a = reinterpret_cast<Word*>(elements.data());
+  const Word* b = reinterpret_cast<const Word*>(m.elements.data());
+
+  // Branchless, so the loop is vectorized
+  elementwise(elements.size(), [&](std::size_t begin, std::size_t count){
+    for(std::size_t i = begin; i < begin + count; i++){
+      const Word sum = a[i] + b[i];
+      a[i] = sum >= p ? sum - p : sum;
+    }
+  });
+
+  return *this;
+}
+
+ModularSquareMatrix& ModularSquareMatrix::operator-=(const ModularSquareMatrix& m){
+
+  checkOperands(m);
+
+  const Word p = mod.value();
+  Word* a = reinterpret_cast<Word*>(elements.data());
+  const Word* b = reinterpret_cast<const Word*>(m.elements.data());
+
+  elementwise(elements.size(), [&](std::size_t begin, std::size_t count){
+    for(std::size_t i = begin; i < begin + count; i++){
+      const Word difference = a[i] - b[i];
+      a[i] = a[i] < b[i] ? difference + p : difference;
+    }
+  });
+
+  return *this;
+}
+
+ModularSquareMatrix& ModularSquareMatrix::operator*=(const ModularSquareMatrix& m){
+
+  ModularSquareMatrix result = *this * m;
+
+  std::swap(elements, result.elements);
+
+  return *this;
+}
+
+ModularSquareMatrix ModularSquareMatrix::operator+(const ModularSquareMatrix& m) const{
+
+  ModularSquareMatrix result{*this};
+  result += m;
+  return result;
+}
+
+ModularSquareMatrix ModularSquareMatrix::operator-(const ModularSquareMatrix& m) const{
+
+  ModularSquareMatrix result{*this};
+  result -= m;
+  return result;
+}
+
+ModularSquareMatrix ModularSquareMatrix::operator*(const ModularSquareMatrix& m) const{
+
+  checkOperands(m);
+
+  // Panels are added into residues of result, so it starts from zero
+  ModularSquareMatrix result{mod.value(), n};
+
+  const Word* a = reinterpret_cast<const Word*>(elements.data());
+  const Word* b = reinterpret_cast<const Word*>(m.elements.data());
+  Word* c = reinterpret_cast<Word*>(result.elements.data());
+
+  const std::size_t size = n;
+  ThreadPool& pool = ThreadPool::shared();
+
+  if(pool.size() == 1 || size * size * size < parallelProduct){
+    modularGemm(mod, size, size, size, a, size, b, size, c, size);
+    return result;
+  }
+
+  const std::size_t rowTiles = (size + tileRows - 1) / tileRows;
+  const std::size_t colTiles = (size + tileCols - 1) / tileCols;
+
+  pool.parallelFor(rowTiles * colTiles, [&](std::size_t tile){
+    const std::size_t i = tile / colTiles * tileRows;
+    const std::size_t j = tile % colTiles * tileCols;
+    modularGemm(mod, std::min(tileRows, size - i), std::min(tileCols, size - j), size,
+                a + i * size, size, b + j, size, c + i * size + j, size);
+  });
+
+  return result;
+}
+
+bool ModularSquareMatrix::operator==(const ModularSquareMatrix& m) const{
+
+  return mod == m.mod && n == m.n && std::equal(elements.data(), elements.data() + elements.size(), m.elements.data());
+}
+
+std::string ModularSquareMatrix::toString() const{
+
+  std::stringstream ss;
+
+  ss << '[';
+
+  for(std::size_t i = 0; i < n; i++){
+    ss << '[';
+    for(std::size_t j = 0; j < n; j++){
+      if(j != 0)
+        ss << ',';
+      ss << elements[i * n + j];
+    }
+    ss << ']';
+  }
+
+  ss << ']';
+
+  return ss.str();
+}
+
+std::ostream& operator<<(std::ostream& os, const ModularSquareMatrix& m){
+
+  m.print(os);
+  return os;
+}
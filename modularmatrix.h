@@ -0,0 +1,253 @@
+/**
+  * \file modularmatrix.h
+  * \brief Header for Modulus and ModularSquareMatrix classes
+  */
+#ifndef MODULARMATRIX_H
+#define MODULARMATRIX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "elementarymatrix.h"
+#include "densebuffer.h"
+
+/**
+  * \class Modulus
+  * \brief Prime modulus p below 2^31 chosen at runtime, with the constant of Barrett reduction.
+           Residues are in [0, p), so sums of two residues fit in 32 bits and products in 64 bits
+  */
+class Modulus
+{
+public:
+  /**
+    * \brief Constructor for Modulus class. Throws exception if p is not a prime below 2^31
+    * \param p Prime modulus
+    */
+  explicit Modulus(std::uint32_t p);
+
+  /**
+    * \brief Getter for modulus
+    * \return p
+    */
+  std::uint32_t value() const{
+    return p;
+  };
+
+  /**
+    * \brief Reduces any 64-bit value with Barrett reduction, without dividing
+    * \param x Value to be reduced
+    * \return x mod p
+    */
+  std::uint32_t reduce(std::uint64_t x) const{
+
+    // ratio = floor((2^64 - 1) / p) makes q at most 2 below the true quotient
+    const std::uint64_t q = std::uint64_t((unsigned __int128)x * ratio >> 64);
+    std::uint64_t r = x - q * p;
+    r = r >= p ? r - p : r;
+    return std::uint32_t(r >= p ? r - p : r);
+  };
+
+  /**
+    * \brief Maps int into residue, negative values included
+    * \param v Value
+    * \return v mod p in [0, p)
+    */
+  std::uint32_t fromInt(int v) const{
+    const std::uint32_t r = std::uint32_t(std::int64_t(v) % std::int64_t(p) + p);
+    return r >= p ? r - p : r;
+  };
+
+  /**
+    * \brief Number of products of residues that can be added to a sum below 2^63 without overflowing 64 bits
+    * \return Length of lazily reduced sums
+    */
+  std::size_t lazyProducts() const{
+    return lazy;
+  };
+
+  /**
+    * \brief Largest multiple of p not above 2^63. Subtracting it from sums of at least 2^63 brings lazily
+             reduced sums back below 2^63 without changing them mod p
+    * \return Folding constant
+    */
+  std::uint64_t foldConstant() const{
+    return fold;
+  };
+
+  /**
+    * \brief Operator overload for operator ==
+    * \param m Modulus to be compared to
+    * \return True if moduli are equal, else false
+    */
+  bool operator==(const Modulus& m) const{
+    return p == m.p;
+  };
+
+private:
+  std::uint32_t p;
+  std::uint64_t ratio;
+  std::size_t lazy;
+  std::uint64_t fold;
+
+};
+
+/**
+  * \class ModularSquareMatrix
+  * \brief Integer square matrix over Z/pZ for a prime p chosen at runtime. Values are stored as residues in
+           one aligned, row-major DenseBuffer. Results are exact residues of the integer results, with no
+           overflow: sums are reduced by one conditional subtraction, and products accumulate in 64 bits,
+           folded below 2^63 every Modulus::lazyProducts() terms and reduced once per panel of the product
+  */
+class ModularSquareMatrix
+{
+public:
+  /**
+    * \brief Constructor for size n zero matrix
+    * \param p Prime modulus, throws exception if not a prime below 2^31
+    * \param length Size of matrix
+    */
+  ModularSquareMatrix(std::uint32_t p, unsigned int length);
+
+  /**
+    * \brief Constructor parsing matrix text "[[a,b][c,d]]" of ConcreteSquareMatrix. Values are reduced mod p.
+             Throws exception if text is not a square matrix of ints or p is not a prime below 2^31
+    * \param p Prime modulus
+    * \param str_m String containing matrix
+    */
+  ModularSquareMatrix(std::uint32_t p, const std::string& str_m);
+
+  /**
+    * \brief Constructor reducing values of dense matrix mod p
+    * \param p Prime modulus, throws exception if not a prime below 2^31
+    * \param m ConcreteSquareMatrix to be reduced
+    */
+  ModularSquareMatrix(std::uint32_t p, const ConcreteSquareMatrix& m);
+
+  /**
+    * \brief Getter for modulus
+    * \return Prime modulus
+    */
+  std::uint32_t prime() const{
+    return mod.value();
+  };
+
+  /**
+    * \brief Getter for size
+    * \return Number of rows and columns
+    */
+  unsigned int size() const{
+    return n;
+  };
+
+  /**
+    * \brief Returns residue in row i and column j. Throws std::out_of_range if either is not below size
+    * \param i Row
+    * \param j Column
+    * \return Residue in [0, p)
+    */
+  std::uint32_t at(unsigned int i, unsigned int j) const;
+
+  /**
+    * \brief Converts residues into ConcreteSquareMatrix
+    * \return ConcreteSquareMatrix of residues in [0, p)
+    */
+  ConcreteSquareMatrix toConcrete() const;
+
+  /**
+    * \brief Operator overload for operator +=
+    * \param m ModularSquareMatrix to be summed to self
+    * \return Self. Throws exception if sizes or moduli differ
+    */
+  ModularSquareMatrix& operator+=(const ModularSquareMatrix& m);
+
+  /**
+    * \brief Operator overload for operator -=
+    * \param m ModularSquareMatrix to be subtracted from self
+    * \return Self. Throws exception if sizes or moduli differ
+    */
+  ModularSquareMatrix& operator-=(const ModularSquareMatrix& m);
+
+  /**
+    * \brief Operator overload for operator *=
+    * \param m ModularSquareMatrix to multiply self by
+    * \return Self. Throws exception if sizes or moduli differ
+    */
+  ModularSquareMatrix& operator*=(const ModularSquareMatrix& m);
+
+  /**
+    * \brief Operator overload for operator +
+    * \param m ModularSquareMatrix to be summed
+    * \return Sum mod p. Throws exception if sizes or moduli differ
+    */
+  ModularSquareMatrix operator+(const ModularSquareMatrix& m) const;
+
+  /**
+    * \brief Operator overload for operator -
+    * \param m ModularSquareMatrix to be subtracted
+    * \return Difference mod p. Throws exception if sizes or moduli differ
+    */
+  ModularSquareMatrix operator-(const ModularSquareMatrix& m) const;
+
+  /**
+    * \brief Operator overload for operator *. Blocked like gemm, with products summed lazily in 64-bit
+             register tiles, and tiles of the result split across the shared ThreadPool
+    * \param m ModularSquareMatrix to be multiplied by
+    * \return Product mod p. Throws exception if sizes or moduli differ
+    */
+  ModularSquareMatrix operator*(const ModularSquareMatrix& m) const;
+
+  /**
+    * \brief Operator overload for operator ==
+    * \param m ModularSquareMatrix to be compared to
+    * \return True if moduli and residues are identical, else false
+    */
+  bool operator==(const ModularSquareMatrix& m) const;
+
+  /**
+    * \brief Returns residues in the string format of ConcreteSquareMatrix
+    * \return Matrix in predetermined string format
+    */
+  std::string toString() const;
+
+  /**
+    * \brief Prints toString() to output stream
+    * \param os Output stream
+    */
+  void print(std::ostream& os) const{
+
+    os << toString();
+  };
+
+  /**
+    * \brief Throws exception if matrices are not the same size or have different moduli
+    * \param m ModularSquareMatrix to be compared to self
+    */
+  void checkOperands(const ModularSquareMatrix& m) const{
+
+    if(n != m.n){
+      throw std::invalid_argument{"Square matrices are not same size."};
+    }
+    if(!(mod == m.mod)){
+      throw std::invalid_argument{"Square matrices have different moduli."};
+    }
+  };
+
+private:
+  Modulus mod;
+  unsigned int n;
+  DenseBuffer elements;
+
+  friend class ExactSquareMatrix;
+
+};
+
+/**
+  * \brief Operator overload for operator <<
+  * \param os Output stream
+  * \param m ModularSquareMatrix to be printed to output stream
+  * \return Output stream with contents of square matrix printed
+  */
+std::ostream& operator<<(std::ostream& os, const ModularSquareMatrix& m);
+
+#endif // MODULARMATRIX_H
@@ -0,0 +1,354 @@
+/**
+  * \file polynomialelement.cpp
+  * \brief PolynomialElement class
+  */
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <unordered_map>
+#include "polynomialelement.h"
+#include "compositeelement.h"
+#include "sumelement.h"
+#include "bytecode.h"
+
+namespace{
+
+  using Exponent = PolynomialElement::Exponent;
+
+  std::uint64_t degree(const Exponent* row, std::size_t width){
+    return std::accumulate(row, row + width, std::uint64_t(0));
+  }
+
+  /**
+    * \brief Term order: higher degree first, then lexicographically larger exponents first
+    */
+  bool precedes(const Exponent* a, const Exponent* b, std::size_t width){
+    const std::uint64_t da = degree(a, width);
+    const std::uint64_t db = degree(b, width);
+    if(da != db)
+      return da > db;
+    return std::lexicographical_compare(b, b + width, a, a + width);
+  }
+
+  std::uint32_t power(std::uint32_t base, Exponent e){
+    std::uint32_t result = 1;
+    for(; e != 0; e >>= 1){
+      if(e & 1)
+        result *= base;
+      base *= base;
+    }
+    return result;
+  }
+
+}
+
+PolynomialElement::PolynomialElement(){
+
+  normalize();
+}
+
+PolynomialElement::PolynomialElement(int value) : coeffs{value}{
+
+  normalize();
+}
+
+PolynomialElement::PolynomialElement(char var) : vars{var}, exps{1}, coeffs{1}{
+
+  if(Valuation::slot(var) == Valuation::variableCount)
+    throw std::invalid_argument{"Char needs to be A-Z or a-z."};
+
+  normalize();
+}
+
+PolynomialElement PolynomialElement::of(const Element& e){
+
+  Cache cache;
+  return of(e, cache);
+}
+
+const PolynomialElement& PolynomialElement::of(const Element& e, Cache& cache){
+
+  // Shared subexpressions are expanded once
+  auto found = cache.find(&e);
+  if(found != cache.end())
+    return found->second;
+
+  PolynomialElement p;
+
+  if(auto poly = dynamic_cast<const PolynomialElement*>(&e))
+    p = *poly;
+  else if(auto i = dynamic_cast<const IntElement*>(&e))
+    p = PolynomialElement{i->getVal()};
+  else if(auto v = dynamic_cast<const VariableElement*>(&e))
+    p = PolynomialElement{v->getVal()};
+  else if(auto c = dynamic_cast<const CompositeElement*>(&e)){
+    const PolynomialElement& p1 = of(*c->first(), cache);
+    const PolynomialElement& p2 = of(*c->second(), cache);
+    switch(c->operation()){
+      case '+': p = p1 + p2; break;
+      case '-': p = p1 - p2; break;
+      case '*': p = p1 * p2; break;
+      default: throw std::invalid_argument{"Unknown operation in element."};
+    }
+  }
+  else if(auto s = dynamic_cast<const SumElement*>(&e))
+    p = s->polynomial(cache);
+  else
+    throw std::invalid_argument{"Element cannot be converted into polynomial."};
+
+  return cache.emplace(&e, std::move(p)).first->second;
+}
+
+void PolynomialElement::normalize(){
+
+  const std::size_t width = vars.size();
+  const std::size_t terms = coeffs.size();
+
+  std::vector<std::size_t> order(terms);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b){
+    return precedes(exps.data() + a * width, exps.data() + b * width, width);
+  });
+
+  // Equal monomials are adjacent, their coefficients are summed and zero sums dropped
+  std::vector<Exponent> sortedExps;
+  std::vector<int> sortedCoeffs;
+  sortedExps.reserve(exps.size());
+  sortedCoeffs.reserve(terms);
+
+  for(std::size_t i = 0; i < terms;){
+    const Exponent* row = exps.data() + order[i] * width;
+    std::uint32_t sum = 0;
+    std::size_t j = i;
+    for(; j < terms && std::equal(row, row + width, exps.data() + order[j] * width); j++){
+      sum += std::uint32_t(coeffs[order[j]]);
+    }
+    if(sum != 0){
+      sortedExps.insert(sortedExps.end(), row, row + width);
+      sortedCoeffs.push_back(int(sum));
+    }
+    i = j;
+  }
+
+  // Variables whose terms all cancelled are removed
+  std::vector<std::size_t> used;
+  for(std::size_t k = 0; k < width; k++){
+    for(std::size_t t = 0; t < sortedCoeffs.size(); t++){
+      if(sortedExps[t * width + k] != 0){
+        used.push_back(k);
+        break;
+      }
+    }
+  }
+
+  if(used.size() != width){
+    std::vector<char> usedVars;
+    std::vector<Exponent> usedExps;
+    usedExps.reserve(sortedCoeffs.size() * used.size());
+    for(std::size_t k : used){
+      usedVars.push_back(vars[k]);
+    }
+    for(std::size_t t = 0; t < sortedCoeffs.size(); t++){
+      for(std::size_t k : used){
+        usedExps.push_back(sortedExps[t * width + k]);
+      }
+    }
+    vars = std::move(usedVars);
+    sortedExps = std::move(usedExps);
+  }
+
+  exps = std::move(sortedExps);
+  coeffs = std::move(sortedCoeffs);
+
+  structuralHash = hashCombine(4, vars.size());
+  for(char var : vars){
+    structuralHash = hashCombine(structuralHash, std::size_t(var));
+  }
+  for(Exponent e : exps){
+    structuralHash = hashCombine(structuralHash, e);
+  }
+  for(int c : coeffs){
+    structuralHash = hashCombine(structuralHash, std::size_t(unsigned(c)));
+  }
+}
+
+std::vector<PolynomialElement::Exponent> PolynomialElement::exponentsOver(const std::vector<char>& over) const{
+
+  // Position of each own variable among the variables of over, which contains all of them
+  std::vector<std::size_t> column(vars.size());
+  for(std::size_t k = 0; k < vars.size(); k++){
+    column[k] = std::lower_bound(over.begin(), over.end(), vars[k]) - over.begin();
+  }
+
+  std::vector<Exponent> wide(coeffs.size() * over.size());
+  for(std::size_t t = 0; t < coeffs.size(); t++){
+    for(std::size_t k = 0; k < vars.size(); k++){
+      wide[t * over.size() + column[k]] = exps[t * vars.size() + k];
+    }
+  }
+
+  return wide;
+}
+
+Element* PolynomialElement::clone() const{
+
+  return new PolynomialElement{*this};
+}
+
+std::string PolynomialElement::toString() const{
+
+  std::stringstream ss;
+  const std::size_t width = vars.size();
+
+  ss << '{';
+
+  if(coeffs.empty())
+    ss << 0;
+
+  for(std::size_t t = 0; t < coeffs.size(); t++){
+
+    const Exponent* row = exps.data() + t * width;
+    const bool constant = degree(row, width) == 0;
+    std::uint32_t c = std::uint32_t(coeffs[t]);
+
+    if(coeffs[t] < 0){
+      ss << '-';
+      c = 0 - c;
+    }
+    else if(t != 0){
+      ss << '+';
+    }
+
+    bool first = true;
+    if(c != 1 || constant){
+      ss << c;
+      first = false;
+    }
+
+    for(std::size_t k = 0; k < width; k++){
+      if(row[k] == 0)
+        continue;
+      if(!first)
+        ss << '*';
+      ss << vars[k];
+      if(row[k] != 1)
+        ss << '^' << row[k];
+      first = false;
+    }
+  }
+
+  ss << '}';
+
+  return ss.str();
+}
+
+int PolynomialElement::evaluate(const Valuation& v) const{
+
+  const std::size_t width = vars.size();
+
+  std::vector<std::uint32_t> values(width);
+  for(std::size_t k = 0; k < width; k++){
+    values[k] = std::uint32_t(v.at(vars[k]));
+  }
+
+  std::uint32_t sum = 0;
+  for(std::size_t t = 0; t < coeffs.size(); t++){
+    std::uint32_t term = std::uint32_t(coeffs[t]);
+    for(std::size_t k = 0; k < width; k++){
+      if(exps[t * width + k] != 0)
+        term *= power(values[k], exps[t * width + k]);
+    }
+    sum += term;
+  }
+
+  return int(sum);
+}
+
+void PolynomialElement::compile(Bytecode& code) const{
+
+  const std::size_t width = vars.size();
+
+  if(coeffs.empty()){
+    code.pushConstant(0);
+    return;
+  }
+
+  for(std::size_t t = 0; t < coeffs.size(); t++){
+
+    code.pushConstant(coeffs[t]);
+    // Powers are one instruction each, however large the exponent
+    for(std::size_t k = 0; k < width; k++){
+      const Exponent e = exps[t * width + k];
+      if(e == 0)
+        continue;
+      code.pushVariable(vars[k]);
+      if(e != 1)
+        code.pushPower(e);
+      code.pushOperation('*');
+    }
+
+    if(t != 0)
+      code.pushOperation('+');
+  }
+}
+
+bool PolynomialElement::equals(const Element& e) const{
+
+  const PolynomialElement* p = dynamic_cast<const PolynomialElement*>(&e);
+
+  return p != nullptr && p->structuralHash == structuralHash && p->vars == vars && p->coeffs == coeffs && p->exps == exps;
+}
+
+PolynomialElement operator+(const PolynomialElement& p1, const PolynomialElement& p2){
+
+  PolynomialElement result;
+  std::set_union(p1.vars.begin(), p1.vars.end(), p2.vars.begin(), p2.vars.end(), std::back_inserter(result.vars));
+
+  result.exps = p1.exponentsOver(result.vars);
+  std::vector<PolynomialElement::Exponent> second = p2.exponentsOver(result.vars);
+  result.exps.insert(result.exps.end(), second.begin(), second.end());
+
+  result.coeffs = p1.coeffs;
+  result.coeffs.insert(result.coeffs.end(), p2.coeffs.begin(), p2.coeffs.end());
+
+  result.normalize();
+  return result;
+}
+
+PolynomialElement operator-(const PolynomialElement& p1, const PolynomialElement& p2){
+
+  PolynomialElement negated{p2};
+  for(int& c : negated.coeffs){
+    c = int(0 - std::uint32_t(c));
+  }
+
+  return p1 + negated;
+}
+
+PolynomialElement operator*(const PolynomialElement& p1, const PolynomialElement& p2){
+
+  PolynomialElement result;
+  std::set_union(p1.vars.begin(), p1.vars.end(), p2.vars.begin(), p2.vars.end(), std::back_inserter(result.vars));
+
+  const std::size_t width = result.vars.size();
+  const std::vector<PolynomialElement::Exponent> first = p1.exponentsOver(result.vars);
+  const std::vector<PolynomialElement::Exponent> second = p2.exponentsOver(result.vars);
+
+  result.exps.resize(p1.coeffs.size() * p2.coeffs.size() * width);
+  result.coeffs.resize(p1.coeffs.size() * p2.coeffs.size());
+
+  // Every pair of terms, combined by normalize
+  std::size_t t = 0;
+  for(std::size_t i = 0; i < p1.coeffs.size(); i++){
+    for(std::size_t j = 0; j < p2.coeffs.size(); j++, t++){
+      for(std::size_t k = 0; k < width; k++){
+        result.exps[t * width + k] = first[i * width + k] + second[j * width + k];
+      }
+      result.coeffs[t] = int(std::uint32_t(p1.coeffs[i]) * std::uint32_t(p2.coeffs[j]));
+    }
+  }
+
+  result.normalize();
+  return result;
+}
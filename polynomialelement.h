@@ -0,0 +1,160 @@
+/**
+  * \file polynomialelement.h
+  * \brief Header for PolynomialElement class
+  */
+#ifndef POLYNOMIALELEMENT_H
+#define POLYNOMIALELEMENT_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "element.h"
+
+/**
+  * \class PolynomialElement
+  * \brief Element holding an integer polynomial in canonical form. Terms are stored in flat arrays: for every
+           term one coefficient and one exponent per variable of the polynomial. Terms are sorted by
+           descending degree, equal monomials are combined and zero terms dropped, so equal polynomials have
+           identical arrays no matter how they were built. Coefficients wrap like int arithmetic.
+  */
+class PolynomialElement : public Element
+{
+public:
+  using Exponent = std::uint32_t;
+
+  /**
+    * \brief Default constructor for PolynomialElement class. Creates zero polynomial
+    */
+  PolynomialElement();
+
+  /**
+    * \brief Constructor for constant polynomial
+    * \param value Constant
+    */
+  explicit PolynomialElement(int value);
+
+  /**
+    * \brief Constructor for polynomial of one variable. Throws exception if variable is not A-Z or a-z
+    * \param var Variable
+    */
+  explicit PolynomialElement(char var);
+
+  /**
+    * \brief Converts element into polynomial by expanding its operations. Subexpressions shared inside
+             the element are expanded once. Throws exception for unknown operation symbols
+    * \param e Element to be converted
+    * \return Polynomial equal to e
+    */
+  static PolynomialElement of(const Element& e);
+
+  /**
+    * \brief Polynomials of expanded elements by address, for sharing expansions between calls of of
+    */
+  using Cache = std::unordered_map<const Element*, PolynomialElement>;
+
+  /**
+    * \brief Converts element into polynomial, reusing and extending expansions in cache. Elements in cache
+             must stay alive while it is used
+    * \param e Element to be converted
+    * \param cache Expansions of elements converted earlier
+    * \return Polynomial equal to e
+    */
+  static const PolynomialElement& of(const Element& e, Cache& cache);
+
+  /**
+    * \brief Getter for number of terms
+    * \return Number of terms with nonzero coefficient
+    */
+  std::size_t termCount() const{
+    return coeffs.size();
+  };
+
+  /**
+    * \brief Getter for variables
+    * \return Variables appearing in some term, in ascending order
+    */
+  const std::vector<char>& variables() const{
+    return vars;
+  };
+
+  /**
+    * \brief Creates a clone of self and returns pointer to it
+    * \return Pointer to clone of self
+    */
+  Element* clone() const override;
+
+  /**
+    * \brief Returns polynomial in braces, ex. "{3*x^2*y-x+1}"
+    * \return Polynomial in string form
+    */
+  std::string toString() const override;
+
+  /**
+    * \brief Evaluates polynomial. Throws std::out_of_range if a variable is not mapped
+    * \param v Map for char variables and int values
+    * \return Value of polynomial
+    */
+  int evaluate(const Valuation& v) const override;
+
+  /**
+    * \brief Appends instructions computing polynomial term by term to bytecode, with one Power
+             instruction per variable of a term
+    * \param code Bytecode to be appended to
+    */
+  void compile(Bytecode& code) const override;
+
+  /**
+    * \brief Returns hash of canonical terms, computed once when polynomial is built
+    * \return Hash of polynomial
+    */
+  std::size_t hash() const override{
+    return structuralHash;
+  };
+
+  /**
+    * \brief Compares polynomials term by term
+    * \param e Element to be compared to self
+    * \return True if e is PolynomialElement with the same terms, else false
+    */
+  bool equals(const Element& e) const override;
+
+  friend PolynomialElement operator+(const PolynomialElement& p1, const PolynomialElement& p2);
+  friend PolynomialElement operator-(const PolynomialElement& p1, const PolynomialElement& p2);
+  friend PolynomialElement operator*(const PolynomialElement& p1, const PolynomialElement& p2);
+
+private:
+  void normalize();
+  std::vector<Exponent> exponentsOver(const std::vector<char>& over) const;
+
+  std::vector<char> vars;
+  std::vector<Exponent> exps;   // termCount() rows of vars.size() exponents
+  std::vector<int> coeffs;
+  std::size_t structuralHash;
+
+};
+
+/**
+  * \brief Operator overload for operator + for PolynomialElements
+  * \param p1 Polynomial to be summed
+  * \param p2 Polynomial to be summed
+  * \return Canonical sum
+  */
+PolynomialElement operator+(const PolynomialElement& p1, const PolynomialElement& p2);
+
+/**
+  * \brief Operator overload for operator - for PolynomialElements
+  * \param p1 Polynomial to be subtracted from
+  * \param p2 Polynomial to be subtracted
+  * \return Canonical difference
+  */
+PolynomialElement operator-(const PolynomialElement& p1, const PolynomialElement& p2);
+
+/**
+  * \brief Operator overload for operator * for PolynomialElements
+  * \param p1 Polynomial to be multiplied
+  * \param p2 Polynomial to be multiplied
+  * \return Canonical product
+  */
+PolynomialElement operator*(const PolynomialElement& p1, const PolynomialElement& p2);
+
+#endif // POLYNOMIALELEMENT_H
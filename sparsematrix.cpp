@@ -0,0 +1,494 @@
+/**
+  * \file sparsematrix.cpp
+  * \brief SparseSquareMatrix class
+  */
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include "sparsematrix.h"
+#include "matrixparser.h"
+#include "threadpool.h"
+
+namespace{
+
+  using Word = std::uint32_t;
+
+  // Below this many multiply-adds one thread is faster than splitting
+  constexpr std::size_t parallelWork = std::size_t(1) << 18;
+
+  // Blocks of rows per thread, so threads that finish early can steal from slower ones
+  constexpr std::size_t blocksPerThread = 16;
+
+  /**
+    * \brief Dense row of sums with a list of touched columns, kept zeroed between rows.
+             One per thread, sized for the largest matrix multiplied on it
+    */
+  struct Accumulator{
+    std::vector<Word> sums;
+    std::vector<unsigned char> seen;
+    std::vector<unsigned int> touched;
+
+    void reserve(std::size_t n){
+      if(sums.size() < n){
+        sums.resize(n);
+        seen.resize(n);
+      }
+    }
+  };
+
+  /**
+    * \brief Compressed rows of a block of the product, with lengths in place of starts
+    */
+  struct RowBlock{
+    std::vector<std::size_t> lengths;
+    std::vector<unsigned int> indices;
+    std::vector<int> values;
+  };
+
+  /**
+    * \brief Runs rows(first, last, block) for blocks of rows, on the shared ThreadPool if work is large enough
+    */
+  template <typename Rows>
+  void forRowBlocks(std::size_t n, std::size_t work, std::vector<RowBlock>& blocks, Rows rows){
+
+    ThreadPool& pool = ThreadPool::shared();
+
+    const std::size_t count = pool.size() == 1 || work < parallelWork
+                              ? 1 : std::min(n, std::size_t(pool.size()) * blocksPerThread);
+
+    blocks.resize(count);
+    if(count == 1){
+      rows(0, n, blocks[0]);
+      return;
+    }
+
+    pool.parallelFor(count, [&](std::size_t b){
+      rows(n * b / count, n * (b + 1) / count, blocks[b]);
+    });
+  }
+
+  /**
+    * \brief Joins blocks of rows into compressed rows
+    */
+  CompressedLines join(std::size_t n, std::vector<RowBlock>& blocks){
+
+    CompressedLines lines;
+    lines.starts.reserve(n + 1);
+    lines.starts.push_back(0);
+
+    std::size_t total = 0;
+    for(const RowBlock& block : blocks){
+      for(std::size_t length : block.lengths){
+        total += length;
+        lines.starts.push_back(total);
+      }
+    }
+
+    // One block is moved instead of copied
+    if(blocks.size() == 1){
+      lines.indices = std::move(blocks[0].indices);
+      lines.values = std::move(blocks[0].values);
+      return lines;
+    }
+
+    lines.indices.reserve(total);
+    lines.values.reserve(total);
+    for(RowBlock& block : blocks){
+      lines.indices.insert(lines.indices.end(), block.indices.begin(), block.indices.end());
+      lines.values.insert(lines.values.end(), block.values.begin(), block.values.end());
+      block = RowBlock{};
+    }
+
+    return lines;
+  }
+
+  /**
+    * \brief Merges compressed rows of a and b, negating values of b if subtract is true
+    */
+  CompressedLines merge(std::size_t n, const CompressedLines& a, const CompressedLines& b, bool subtract){
+
+    CompressedLines lines;
+    lines.starts.reserve(n + 1);
+    lines.starts.push_back(0);
+    lines.indices.reserve(a.values.size() + b.values.size());
+    lines.values.reserve(a.values.size() + b.values.size());
+
+    auto push = [&](unsigned int j, Word v){
+      if(v != 0){
+        lines.indices.push_back(j);
+        lines.values.push_back(int(v));
+      }
+    };
+
+    for(std::size_t i = 0; i < n; i++){
+
+      std::size_t p = a.starts[i];
+      std::size_t q = b.starts[i];
+      const std::size_t pEnd = a.starts[i + 1];
+      const std::size_t qEnd = b.starts[i + 1];
+
+      while(p != pEnd || q != qEnd){
+        const unsigned int ja = p != pEnd ? a.indices[p] : unsigned(n);
+        const unsigned int jb = q != qEnd ? b.indices[q] : unsigned(n);
+        const Word va = ja <= jb ? Word(a.values[p]) : 0;
+        const Word vb = jb <= ja ? Word(b.values[q]) : 0;
+
+        push(std::min(ja, jb), subtract ? va - vb : va + vb);
+
+        if(ja <= jb)
+          p++;
+        if(jb <= ja)
+          q++;
+      }
+
+      lines.starts.push_back(lines.values.size());
+    }
+
+    return lines;
+  }
+
+}
+
+SparseSquareMatrix::SparseSquareMatrix(unsigned int length) : n{length}{
+
+  csr.starts.assign(std::size_t(length) + 1, 0);
+}
+
+SparseSquareMatrix::SparseSquareMatrix(const std::string& str_m){
+
+  // Cells arrive in row-major order, so nonzeros are appended and counted per row
+  const std::size_t size = firstRowLength(str_m);
+  CompressedLines lines;
+  lines.starts.assign(size + 1, 0);
+
+  auto store = [&](std::size_t i, const MatrixCell& cell){
+    if(cell.value != 0){
+      lines.indices.push_back(unsigned(i % size));
+      lines.values.push_back(cell.value);
+      lines.starts[i / size + 1]++;
+    }
+  };
+
+  if(!parseSquareMatrix(str_m, size, false, store))
+    throw std::invalid_argument{"Not square matrix adhering to predetermined form."};
+
+  for(std::size_t i = 0; i < size; i++){
+    lines.starts[i + 1] += lines.starts[i];
+  }
+
+  n = size;
+  csr = std::move(lines);
+}
+
+SparseSquareMatrix::SparseSquareMatrix(const ConcreteSquareMatrix& m) : n{m.n}{
+
+  const int* values = m.elements.data();
+
+  csr.starts.reserve(std::size_t(n) + 1);
+  csr.starts.push_back(0);
+
+  for(std::size_t i = 0; i < n; i++){
+    for(unsigned int j = 0; j < n; j++){
+      if(values[i * n + j] != 0){
+        csr.indices.push_back(j);
+        csr.values.push_back(values[i * n + j]);
+      }
+    }
+    csr.starts.push_back(csr.values.size());
+  }
+}
+
+SparseSquareMatrix::SparseSquareMatrix(unsigned int length, CompressedLines rows) : n{length}, csr{std::move(rows)}{
+
+  const std::size_t count = csr.values.size();
+
+  if(csr.starts.size() != std::size_t(n) + 1 || csr.starts.front() != 0 || csr.starts.back() != count
+     || csr.indices.size() != count)
+    throw std::invalid_argument{"Not compressed rows of square matrix."};
+
+  for(std::size_t i = 0; i < n; i++){
+    if(csr.starts[i] > csr.starts[i + 1])
+      throw std::invalid_argument{"Not compressed rows of square matrix."};
+    for(std::size_t p = csr.starts[i]; p < csr.starts[i + 1]; p++){
+      if(csr.indices[p] >= n || (p != csr.starts[i] && csr.indices[p] <= csr.indices[p - 1]))
+        throw std::invalid_argument{"Not compressed rows of square matrix."};
+    }
+  }
+
+  // Stored zeros are removed in place, row starts shift down with them
+  std::size_t kept = 0;
+  std::size_t p = 0;
+  for(std::size_t i = 0; i < n; i++){
+    for(; p < csr.starts[i + 1]; p++){
+      if(csr.values[p] != 0){
+        csr.indices[kept] = csr.indices[p];
+        csr.values[kept] = csr.values[p];
+        kept++;
+      }
+    }
+    csr.starts[i + 1] = kept;
+  }
+
+  csr.indices.resize(kept);
+  csr.values.resize(kept);
+}
+
+ConcreteSquareMatrix SparseSquareMatrix::toDense() const{
+
+  ConcreteSquareMatrix result{n};
+  int* values = result.elements.data();
+
+  for(std::size_t i = 0; i < n; i++){
+    for(std::size_t p = csr.starts[i]; p < csr.starts[i + 1]; p++){
+      values[i * n + csr.indices[p]] = csr.values[p];
+    }
+  }
+
+  return result;
+}
+
+CompressedLines SparseSquareMatrix::columns() const{
+
+  CompressedLines csc;
+  csc.starts.assign(std::size_t(n) + 1, 0);
+  csc.indices.resize(nonZeros());
+  csc.values.resize(nonZeros());
+
+  for(unsigned int j : csr.indices){
+    csc.starts[j + 1]++;
+  }
+  for(std::size_t j = 0; j < n; j++){
+    csc.starts[j + 1] += csc.starts[j];
+  }
+
+  // Rows are visited in order, so every column gets its rows in ascending order
+  std::vector<std::size_t> next(csc.starts.begin(), csc.starts.end() - 1);
+  for(unsigned int i = 0; i < n; i++){
+    for(std::size_t p = csr.starts[i]; p < csr.starts[i + 1]; p++){
+      const std::size_t q = next[csr.indices[p]]++;
+      csc.indices[q] = i;
+      csc.values[q] = csr.values[p];
+    }
+  }
+
+  return csc;
+}
+
+int SparseSquareMatrix::at(unsigned int i, unsigned int j) const{
+
+  if(i >= n || j >= n)
+    throw std::out_of_range{"Index is outside of matrix."};
+
+  const auto first = csr.indices.begin() + csr.starts[i];
+  const auto last = csr.indices.begin() + csr.starts[i + 1];
+  const auto found = std::lower_bound(first, last, j);
+
+  if(found == last || *found != j)
+    return 0;
+  return csr.values[found - csr.indices.begin()];
+}
+
+SparseSquareMatrix SparseSquareMatrix::transpose() const{
+
+  // Columns of self are the rows of the transpose
+  SparseSquareMatrix result;
+  result.n = n;
+  result.csr = columns();
+
+  return result;
+}
+
+SparseSquareMatrix SparseSquareMatrix::operator+(const SparseSquareMatrix& m) const{
+
+  checkOperands(m.n);
+
+  SparseSquareMatrix result;
+  result.n = n;
+  result.csr = merge(n, csr, m.csr, false);
+
+  return result;
+}
+
+SparseSquareMatrix SparseSquareMatrix::operator-(const SparseSquareMatrix& m) const{
+
+  checkOperands(m.n);
+
+  SparseSquareMatrix result;
+  result.n = n;
+  result.csr = merge(n, csr, m.csr, true);
+
+  return result;
+}
+
+SparseSquareMatrix SparseSquareMatrix::operator*(const SparseSquareMatrix& m) const{
+
+  checkOperands(m.n);
+
+  // Multiply-adds of the product, for deciding whether it is worth splitting
+  std::size_t work = 0;
+  for(unsigned int k : csr.indices){
+    work += m.csr.starts[k + 1] - m.csr.starts[k];
+  }
+
+  const CompressedLines& a = csr;
+  const CompressedLines& b = m.csr;
+
+  auto rows = [&](std::size_t first, std::size_t last, RowBlock& block){
+
+    static thread_local Accumulator acc;
+    acc.reserve(n);
+
+    block.lengths.reserve(last - first);
+
+    for(std::size_t i = first; i < last; i++){
+
+      // Row i of the product is the sum of rows k of m scaled by a(i, k)
+      for(std::size_t p = a.starts[i]; p < a.starts[i + 1]; p++){
+        const Word v = Word(a.values[p]);
+        const unsigned int k = a.indices[p];
+        for(std::size_t q = b.starts[k]; q < b.starts[k + 1]; q++){
+          const unsigned int j = b.indices[q];
+          if(!acc.seen[j]){
+            acc.seen[j] = 1;
+            acc.touched.push_back(j);
+          }
+          acc.sums[j] += v * Word(b.values[q]);
+        }
+      }
+
+      std::sort(acc.touched.begin(), acc.touched.end());
+
+      // Sums that cancelled to zero are not stored, accumulator is left zeroed for the next row
+      std::size_t length = 0;
+      for(unsigned int j : acc.touched){
+        if(acc.sums[j] != 0){
+          block.indices.push_back(j);
+          block.values.push_back(int(acc.sums[j]));
+          length++;
+        }
+        acc.sums[j] = 0;
+        acc.seen[j] = 0;
+      }
+      acc.touched.clear();
+
+      block.lengths.push_back(length);
+    }
+  };
+
+  std::vector<RowBlock> blocks;
+  forRowBlocks(n, work, blocks, rows);
+
+  SparseSquareMatrix result;
+  result.n = n;
+  result.csr = join(n, blocks);
+
+  return result;
+}
+
+ConcreteSquareMatrix SparseSquareMatrix::operator*(const ConcreteSquareMatrix& m) const{
+
+  checkOperands(m.n);
+
+  ConcreteSquareMatrix result{n};
+  const int* b = m.elements.data();
+  int* c = result.elements.data();
+
+  auto row = [&](std::size_t i){
+    int* ci = c + i * n;
+    for(std::size_t p = csr.starts[i]; p < csr.starts[i + 1]; p++){
+      const Word v = Word(csr.values[p]);
+      const int* bk = b + std::size_t(csr.indices[p]) * n;
+      for(std::size_t j = 0; j < n; j++){
+        ci[j] = int(Word(ci[j]) + v * Word(bk[j]));
+      }
+    }
+  };
+
+  ThreadPool& pool = ThreadPool::shared();
+  if(pool.size() == 1 || nonZeros() * n < parallelWork){
+    for(std::size_t i = 0; i < n; i++)
+      row(i);
+  }
+  else{
+    pool.parallelFor(n, row);
+  }
+
+  return result;
+}
+
+ConcreteSquareMatrix SparseSquareMatrix::multiply(const ConcreteSquareMatrix& d, const SparseSquareMatrix& m){
+
+  m.checkOperands(d.n);
+
+  const std::size_t n = m.n;
+  const CompressedLines& b = m.csr;
+  ConcreteSquareMatrix result{m.n};
+  const int* a = d.elements.data();
+  int* c = result.elements.data();
+
+  auto row = [&](std::size_t i){
+    int* ci = c + i * n;
+    for(std::size_t k = 0; k < n; k++){
+      const Word v = Word(a[i * n + k]);
+      if(v == 0)
+        continue;
+      for(std::size_t q = b.starts[k]; q < b.starts[k + 1]; q++){
+        ci[b.indices[q]] = int(Word(ci[b.indices[q]]) + v * Word(b.values[q]));
+      }
+    }
+  };
+
+  ThreadPool& pool = ThreadPool::shared();
+  if(pool.size() == 1 || (n + m.nonZeros()) * n < parallelWork){
+    for(std::size_t i = 0; i < n; i++)
+      row(i);
+  }
+  else{
+    pool.parallelFor(n, row);
+  }
+
+  return result;
+}
+
+bool SparseSquareMatrix::operator==(const SparseSquareMatrix& m) const{
+
+  return n == m.n && csr.starts == m.csr.starts && csr.indices == m.csr.indices && csr.values == m.csr.values;
+}
+
+std::string SparseSquareMatrix::toString() const{
+
+  std::stringstream ss;
+
+  ss << '[';
+
+  for(std::size_t i = 0; i < n; i++){
+    std::size_t p = csr.starts[i];
+    ss << '[';
+    for(unsigned int j = 0; j < n; j++){
+      if(j != 0)
+        ss << ',';
+      if(p != csr.starts[i + 1] && csr.indices[p] == j)
+        ss << csr.values[p++];
+      else
+        ss << 0;
+    }
+    ss << ']';
+  }
+
+  ss << ']';
+
+  return ss.str();
+}
+
+ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& d, const SparseSquareMatrix& m){
+
+  return SparseSquareMatrix::multiply(d, m);
+}
+
+std::ostream& operator<<(std::ostream& os, const SparseSquareMatrix& m){
+
+  m.print(os);
+  return os;
+}
@@ -0,0 +1,208 @@
+/**
+  * \file sparsematrix.h
+  * \brief Header for SparseSquareMatrix class
+  */
+#ifndef SPARSEMATRIX_H
+#define SPARSEMATRIX_H
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "elementarymatrix.h"
+
+/**
+  * \brief Compressed sparse lines of a square matrix. Nonzero values of line i are
+           values[starts[i]] ... values[starts[i + 1] - 1], and indices holds their positions on the line in
+           ascending order. Lines are rows in CSR form and columns in CSC form
+  */
+struct CompressedLines{
+  std::vector<std::size_t> starts;
+  std::vector<unsigned int> indices;
+  std::vector<int> values;
+};
+
+/**
+  * \class SparseSquareMatrix
+  * \brief Integer square matrix storing only nonzero values, in compressed sparse row (CSR) form.
+           Memory and operations scale with the number of nonzeros instead of the size of the matrix.
+           Zeros are never stored, so equal matrices have identical arrays. Arithmetic wraps like
+           ConcreteSquareMatrix, so results match the dense operations
+  */
+class SparseSquareMatrix
+{
+public:
+  /**
+    * \brief Default constructor for SparseSquareMatrix class. Creates empty matrix
+    */
+  SparseSquareMatrix() : SparseSquareMatrix{0}{};
+
+  /**
+    * \brief Constructor for size n zero matrix
+    * \param length Size of matrix
+    */
+  explicit SparseSquareMatrix(unsigned int length);
+
+  /**
+    * \brief Constructor parsing matrix text "[[a,b][c,d]]" of ConcreteSquareMatrix. Only nonzero cells
+             are kept. Throws exception if text is not a square matrix of ints
+    * \param str_m String containing matrix
+    */
+  explicit SparseSquareMatrix(const std::string& str_m);
+
+  /**
+    * \brief Constructor converting dense matrix
+    * \param m ConcreteSquareMatrix to be converted
+    */
+  explicit SparseSquareMatrix(const ConcreteSquareMatrix& m);
+
+  /**
+    * \brief Constructor adopting compressed rows. Throws exception if rows are not valid CSR of a size
+             length matrix with ascending column indices. Zero values are dropped
+    * \param length Size of matrix
+    * \param rows Compressed rows
+    */
+  SparseSquareMatrix(unsigned int length, CompressedLines rows);
+
+  /**
+    * \brief Converts into dense matrix
+    * \return ConcreteSquareMatrix with the same values
+    */
+  ConcreteSquareMatrix toDense() const;
+
+  /**
+    * \brief Getter for size
+    * \return Number of rows and columns
+    */
+  unsigned int size() const{
+    return n;
+  };
+
+  /**
+    * \brief Getter for number of stored values
+    * \return Number of nonzero values
+    */
+  std::size_t nonZeros() const{
+    return csr.values.size();
+  };
+
+  /**
+    * \brief Getter for compressed rows
+    * \return Matrix in CSR form
+    */
+  const CompressedLines& rows() const{
+    return csr;
+  };
+
+  /**
+    * \brief Builds compressed columns
+    * \return Matrix in CSC form
+    */
+  CompressedLines columns() const;
+
+  /**
+    * \brief Returns value in row i and column j. Throws std::out_of_range if either is not below size
+    * \param i Row
+    * \param j Column
+    * \return Value, 0 if not stored
+    */
+  int at(unsigned int i, unsigned int j) const;
+
+  /**
+    * \brief Returns transpose, built from the compressed columns of self
+    * \return Transposed matrix
+    */
+  SparseSquareMatrix transpose() const;
+
+  /**
+    * \brief Operator overload for operator + for SparseSquareMatrices. Rows are merged, cancelled values dropped
+    * \param m SparseSquareMatrix to be summed
+    * \return Sum of matrices. Throws exception if sizes differ
+    */
+  SparseSquareMatrix operator+(const SparseSquareMatrix& m) const;
+
+  /**
+    * \brief Operator overload for operator - for SparseSquareMatrices. Rows are merged, cancelled values dropped
+    * \param m SparseSquareMatrix to be subtracted
+    * \return Difference of matrices. Throws exception if sizes differ
+    */
+  SparseSquareMatrix operator-(const SparseSquareMatrix& m) const;
+
+  /**
+    * \brief Operator overload for operator * for SparseSquareMatrices. Rows of the product are computed
+             independently by Gustavson's algorithm, scaling every row of m by a value of the row of self
+             into a dense accumulator, and blocks of rows are split across the shared ThreadPool
+    * \param m SparseSquareMatrix to be multiplied by
+    * \return Product of matrices. Throws exception if sizes differ
+    */
+  SparseSquareMatrix operator*(const SparseSquareMatrix& m) const;
+
+  /**
+    * \brief Operator overload for operator * for SparseSquareMatrix and ConcreteSquareMatrix. Every row of
+             the product sums rows of m scaled by the values of the row of self
+    * \param m ConcreteSquareMatrix to be multiplied by
+    * \return Dense product of matrices. Throws exception if sizes differ
+    */
+  ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& m) const;
+
+  /**
+    * \brief Operator overload for operator ==
+    * \param m SparseSquareMatrix to be compared to
+    * \return True if matrices are identical, else false
+    */
+  bool operator==(const SparseSquareMatrix& m) const;
+
+  /**
+    * \brief Returns matrix in the string format of ConcreteSquareMatrix, zeros included
+    * \return Matrix in predetermined string format
+    */
+  std::string toString() const;
+
+  /**
+    * \brief Prints toString() to output stream
+    * \param os Output stream
+    */
+  void print(std::ostream& os) const{
+
+    os << toString();
+  };
+
+  /**
+    * \brief Throws exception if matrices are not the same size
+    * \param size Size of other operand
+    */
+  void checkOperands(unsigned int size) const{
+
+    if(n != size){
+      throw std::invalid_argument{"Square matrices are not same size."};
+    }
+  };
+
+private:
+  static ConcreteSquareMatrix multiply(const ConcreteSquareMatrix& d, const SparseSquareMatrix& m);
+
+  unsigned int n;
+  CompressedLines csr;
+
+  friend ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& d, const SparseSquareMatrix& m);
+
+};
+
+/**
+  * \brief Operator overload for operator * for ConcreteSquareMatrix and SparseSquareMatrix. Every row of
+           the product sums the rows of m picked by the nonzero values of the row of d
+  * \param d ConcreteSquareMatrix to be multiplied
+  * \param m SparseSquareMatrix to be multiplied by
+  * \return Dense product of matrices. Throws exception if sizes differ
+  */
+ConcreteSquareMatrix operator*(const ConcreteSquareMatrix& d, const SparseSquareMatrix& m);
+
+/**
+  * \brief Operator overload for operator <<
+  * \param os Output stream
+  * \param m SparseSquareMatrix to be printed to output stream
+  * \return Output stream with contents of square matrix printed
+  */
+std::ostream& operator<<(std::ostream& os, const SparseSquareMatrix& m);
+
+#endif // SPARSEMATRIX_H
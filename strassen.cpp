@@ -0,0 +1,152 @@
+/**
+  * \file strassen.cpp
+  * \brief Strassen-Winograd integer matrix multiplication
+  */
+
+#include <algorithm>
+#include "strassen.h"
+#include "gemm.h"
+#include "vectorkernels.h"
+#include "threadpool.h"
+#include "densebuffer.h"
+
+namespace{
+
+  using RowKernel = void (*)(const int*, const int*, int*, std::size_t);
+
+  // Products this small are faster with the blocked kernel than with the extra additions of splitting.
+  // Splitting 1.5k products loses, 2k and larger ones gain
+  constexpr std::size_t defaultCrossover = 1536;
+
+  // Below this many values one thread keeps up with memory
+  constexpr std::size_t parallelValues = std::size_t(1) << 20;
+
+  std::size_t crossover = defaultCrossover;
+
+  /**
+    * \brief dst = kernel(a, b) for rows x cols blocks, one row at a time. dst may be a or b
+    */
+  void blockwise(RowKernel kernel, std::size_t rows, std::size_t cols,
+                 const int* a, std::size_t lda, const int* b, std::size_t ldb, int* dst, std::size_t ldd){
+
+    ThreadPool& pool = ThreadPool::shared();
+
+    auto row = [&](std::size_t i){
+      kernel(a + i * lda, b + i * ldb, dst + i * ldd, cols);
+    };
+
+    if(pool.size() == 1 || rows * cols < parallelValues){
+      for(std::size_t i = 0; i < rows; i++)
+        row(i);
+      return;
+    }
+
+    pool.parallelFor(rows, row);
+  }
+
+  /**
+    * \brief c += a * b, splitting until a dimension reaches crossover
+    */
+  void multiply(std::size_t m, std::size_t n, std::size_t k,
+                const int* a, std::size_t lda,
+                const int* b, std::size_t ldb,
+                int* c, std::size_t ldc){
+
+    if(m <= crossover || n <= crossover || k <= crossover){
+      parallelGemm(m, n, k, a, lda, b, ldb, c, ldc);
+      return;
+    }
+
+    const std::size_t m2 = m / 2;
+    const std::size_t n2 = n / 2;
+    const std::size_t k2 = k / 2;
+
+    const int* a11 = a;
+    const int* a12 = a + k2;
+    const int* a21 = a + m2 * lda;
+    const int* a22 = a21 + k2;
+    const int* b11 = b;
+    const int* b12 = b + n2;
+    const int* b21 = b + k2 * ldb;
+    const int* b22 = b21 + n2;
+    int* c11 = c;
+    int* c12 = c + n2;
+    int* c21 = c + m2 * ldc;
+    int* c22 = c21 + n2;
+
+    // Products are accumulated straight into c where possible, so four temporaries are enough
+    DenseBuffer u{m2 * n2};
+    DenseBuffer v = DenseBuffer::uninitialized(m2 * n2);
+    DenseBuffer s = DenseBuffer::uninitialized(m2 * k2);
+    DenseBuffer t = DenseBuffer::uninitialized(k2 * n2);
+
+    // C11 = P1 + P2, P1 = A11 * B11, P2 = A12 * B21
+    multiply(m2, n2, k2, a11, lda, b11, ldb, u.data(), n2);
+    blockwise(addInts, m2, n2, c11, ldc, u.data(), n2, c11, ldc);
+    multiply(m2, n2, k2, a12, lda, b21, ldb, c11, ldc);
+
+    // P5 = S1 * T1, S1 = A21 + A22, T1 = B12 - B11, goes to C12 and C22
+    blockwise(addInts, m2, k2, a21, lda, a22, lda, s.data(), k2);
+    blockwise(subtractInts, k2, n2, b12, ldb, b11, ldb, t.data(), n2);
+    std::fill(v.begin(), v.end(), 0);
+    multiply(m2, n2, k2, s.data(), k2, t.data(), n2, v.data(), n2);
+    blockwise(addInts, m2, n2, c12, ldc, v.data(), n2, c12, ldc);
+    blockwise(addInts, m2, n2, c22, ldc, v.data(), n2, c22, ldc);
+
+    // U2 = P1 + P6, P6 = S2 * T2, S2 = S1 - A11, T2 = B22 - T1, goes to C12, C21 and C22
+    blockwise(subtractInts, m2, k2, s.data(), k2, a11, lda, s.data(), k2);
+    blockwise(subtractInts, k2, n2, b22, ldb, t.data(), n2, t.data(), n2);
+    multiply(m2, n2, k2, s.data(), k2, t.data(), n2, u.data(), n2);
+    blockwise(addInts, m2, n2, c12, ldc, u.data(), n2, c12, ldc);
+    blockwise(addInts, m2, n2, c21, ldc, u.data(), n2, c21, ldc);
+    blockwise(addInts, m2, n2, c22, ldc, u.data(), n2, c22, ldc);
+
+    // C12 += P3, P3 = S4 * B22, S4 = A12 - S2
+    blockwise(subtractInts, m2, k2, a12, lda, s.data(), k2, s.data(), k2);
+    multiply(m2, n2, k2, s.data(), k2, b22, ldb, c12, ldc);
+
+    // C21 -= P4, P4 = A22 * T4, T4 = T2 - B21
+    blockwise(subtractInts, k2, n2, t.data(), n2, b21, ldb, t.data(), n2);
+    std::fill(v.begin(), v.end(), 0);
+    multiply(m2, n2, k2, a22, lda, t.data(), n2, v.data(), n2);
+    blockwise(subtractInts, m2, n2, c21, ldc, v.data(), n2, c21, ldc);
+
+    // P7 = S3 * T3, S3 = A11 - A21, T3 = B22 - B12, goes to C21 and C22
+    blockwise(subtractInts, m2, k2, a11, lda, a21, lda, s.data(), k2);
+    blockwise(subtractInts, k2, n2, b22, ldb, b12, ldb, t.data(), n2);
+    std::fill(v.begin(), v.end(), 0);
+    multiply(m2, n2, k2, s.data(), k2, t.data(), n2, v.data(), n2);
+    blockwise(addInts, m2, n2, c21, ldc, v.data(), n2, c21, ldc);
+    blockwise(addInts, m2, n2, c22, ldc, v.data(), n2, c22, ldc);
+
+    // Odd dimensions: last inner index, last column and last row
+    if(k % 2 != 0)
+      parallelGemm(2 * m2, 2 * n2, 1, a + (k - 1), lda, b + (k - 1) * ldb, ldb, c, ldc);
+    if(n % 2 != 0)
+      parallelGemm(2 * m2, 1, k, a, lda, b + (n - 1), ldb, c + (n - 1), ldc);
+    if(m % 2 != 0)
+      parallelGemm(1, n, k, a + (m - 1) * lda, lda, b, ldb, c + (m - 1) * ldc, ldc);
+  }
+
+}
+
+void strassenGemm(std::size_t m, std::size_t n, std::size_t k,
+                  const int* a, std::size_t lda,
+                  const int* b, std::size_t ldb,
+                  int* c, std::size_t ldc){
+
+  if(m == 0 || n == 0 || k == 0)
+    return;
+
+  multiply(m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+std::size_t strassenCrossover(){
+
+  return crossover;
+}
+
+void setStrassenCrossover(std::size_t size){
+
+  crossover = size == 0 ? defaultCrossover : size;
+}
@@ -0,0 +1,43 @@
+/**
+  * \file strassen.h
+  * \brief Header for Strassen-Winograd integer matrix multiplication
+  */
+#ifndef STRASSEN_H
+#define STRASSEN_H
+
+#include <cstddef>
+
+/**
+  * \brief Same as parallelGemm, but large products are split recursively with the Strassen-Winograd
+           scheme of 7 half-size products and 15 additions. Products with a dimension of at most the
+           crossover are computed by parallelGemm. Odd dimensions are handled by splitting off the last
+           row, column or inner index and computing its contribution with gemm. Arithmetic wraps around,
+           so the result is identical to parallelGemm.
+  * \param m Rows of a and c
+  * \param n Columns of b and c
+  * \param k Columns of a and rows of b
+  * \param a Pointer to first value of a
+  * \param lda Distance between rows of a
+  * \param b Pointer to first value of b
+  * \param ldb Distance between rows of b
+  * \param c Pointer to first value of c
+  * \param ldc Distance between rows of c
+  */
+void strassenGemm(std::size_t m, std::size_t n, std::size_t k,
+                  const int* a, std::size_t lda,
+                  const int* b, std::size_t ldb,
+                  int* c, std::size_t ldc);
+
+/**
+  * \brief Getter for crossover of strassenGemm
+  * \return Largest dimension computed by parallelGemm without splitting
+  */
+std::size_t strassenCrossover();
+
+/**
+  * \brief Sets crossover of strassenGemm. Must not be called while strassenGemm runs
+  * \param size Largest dimension computed by parallelGemm without splitting, 0 for default
+  */
+void setStrassenCrossover(std::size_t size);
+
+#endif // STRASSEN_H
@@ -0,0 +1,210 @@
+/**
+  * \file sumelement.cpp
+  * \brief SumElement class
+  */
+
+#include <cstdint>
+#include <stdexcept>
+#include <typeinfo>
+#include "sumelement.h"
+#include "compositeelement.h"
+#include "bytecode.h"
+
+namespace{
+
+  std::size_t chainHash(const std::vector<std::shared_ptr<const Element>>& terms){
+
+    if(terms.size() < 2)
+      throw std::invalid_argument{"Sum needs at least two terms."};
+
+    for(const auto& t : terms){
+      if(!t)
+        throw std::invalid_argument{"Sum term is missing."};
+    }
+
+    std::size_t h = terms[0]->hash();
+    for(std::size_t k = 1; k < terms.size(); k++){
+      h = CompositeElement::combinedHash('+', h, terms[k]->hash());
+    }
+    return h;
+  }
+
+  /**
+    * \brief Whether cell of storage is the same expression as e
+    */
+  bool sameCell(const CellStorage& s, Cell c, const Element& e){
+
+    switch(c.kind()){
+      case Cell::Kind::Int:
+        return typeid(e) == typeid(IntElement) && static_cast<const IntElement&>(e).getVal() == c.value();
+      case Cell::Kind::Variable:
+        return typeid(e) == typeid(VariableElement) && static_cast<const VariableElement&>(e).getVal() == c.name();
+      default:
+        return s.nodes[c.index()].get() == &e || *s.nodes[c.index()] == e;
+    }
+  }
+
+  /**
+    * \brief Returns e as composite if it is one with operation opc, else nullptr
+    */
+  const CompositeElement* asComposite(const Element& e, char opc){
+    const CompositeElement* c = dynamic_cast<const CompositeElement*>(&e);
+    return c != nullptr && c->operation() == opc ? c : nullptr;
+  }
+
+}
+
+SumElement::SumElement(std::vector<std::shared_ptr<const Element>> terms) : structuralHash{chainHash(terms)}{
+
+  items = std::move(terms);
+}
+
+std::size_t SumElement::extendHash(std::size_t sum, std::size_t term){
+
+  return CompositeElement::combinedHash('+', sum, term);
+}
+
+std::size_t SumElement::count() const{
+
+  return items.size();
+}
+
+std::vector<std::shared_ptr<const Element>> SumElement::terms() const{
+
+  return items;
+}
+
+PolynomialElement SumElement::polynomial(PolynomialElement::Cache& cache) const{
+
+  PolynomialElement p = PolynomialElement::of(*items[0], cache);
+  for(std::size_t k = 1; k < items.size(); k++){
+    p = p + PolynomialElement::of(*items[k], cache);
+  }
+  return p;
+}
+
+Element* SumElement::clone() const{
+
+  return new SumElement{*this};
+}
+
+std::string SumElement::toString() const{
+
+  const std::vector<std::shared_ptr<const Element>> t = terms();
+  std::string s(t.size() - 1, '(');
+
+  s += t[0]->toString();
+  for(std::size_t k = 1; k < t.size(); k++){
+    s += '+';
+    s += t[k]->toString();
+    s += ')';
+  }
+
+  return s;
+}
+
+int SumElement::evaluate(const Valuation& v) const{
+
+  std::uint32_t sum = 0;
+  for(const auto& t : items){
+    sum += std::uint32_t(t->evaluate(v));
+  }
+  return int(sum);
+}
+
+void SumElement::compile(Bytecode& code) const{
+
+  CompositeElement::compileOperand(items[0], code);
+  for(std::size_t k = 1; k < items.size(); k++){
+    CompositeElement::compileOperand(items[k], code);
+    code.pushOperation('+');
+  }
+}
+
+bool SumElement::equals(const Element& e) const{
+
+  if(e.hash() != structuralHash)
+    return false;
+
+  const std::vector<TermView> t = views();
+  if(const SumElement* s = dynamic_cast<const SumElement*>(&e)){
+    const std::vector<TermView> u = s->views();
+    return equalSums(t, t.size(), u, u.size());
+  }
+
+  return equalChain(t, t.size(), e);
+}
+
+std::vector<SumElement::TermView> SumElement::views() const{
+
+  std::vector<TermView> t;
+  t.reserve(items.size());
+  for(const auto& item : items){
+    t.push_back(TermView{TermView::Kind::Element, item.get(), nullptr, nullptr, Cell{}, Cell{}});
+  }
+  return t;
+}
+
+bool SumElement::equalViews(const TermView& t, const TermView& u){
+
+  if(t.kind == TermView::Kind::Element)
+    return equalView(u, *t.element);
+  if(u.kind == TermView::Kind::Element)
+    return equalView(t, *u.element);
+  if(t.kind != u.kind)
+    return false;
+
+  switch(t.kind){
+    case TermView::Kind::Product:
+      return t.left->equal(t.a, *u.left, u.a) && t.right->equal(t.b, *u.right, u.b);
+    default:
+      return t.a == u.a;
+  }
+}
+
+bool SumElement::equalView(const TermView& t, const Element& e){
+
+  switch(t.kind){
+    case TermView::Kind::Element:
+      return t.element == &e || *t.element == e;
+    case TermView::Kind::Int:
+    case TermView::Kind::Variable:
+      return sameCell(*t.left, t.a, e);
+    default:
+      const CompositeElement* c = asComposite(e, '*');
+      return c != nullptr && sameCell(*t.left, t.a, *c->first()) && sameCell(*t.right, t.b, *c->second());
+  }
+}
+
+bool SumElement::equalChain(const std::vector<TermView>& t, std::size_t count, const Element& e){
+
+  // Chain ((t0+t1)+t2)... has the last term as the right operand of its root
+  const Element* rest = &e;
+  for(std::size_t k = count - 1; k > 0; k--){
+    if(const SumElement* s = dynamic_cast<const SumElement*>(rest)){
+      const std::vector<TermView> u = s->views();
+      return equalSums(t, k + 1, u, u.size());
+    }
+    const CompositeElement* c = asComposite(*rest, '+');
+    if(c == nullptr || !equalView(t[k], *c->second()))
+      return false;
+    rest = c->first().get();
+  }
+
+  return equalView(t[0], *rest);
+}
+
+bool SumElement::equalSums(const std::vector<TermView>& t, std::size_t count, const std::vector<TermView>& u, std::size_t other){
+
+  for(; count > 1 && other > 1; count--, other--){
+    if(!equalViews(t[count - 1], u[other - 1]))
+      return false;
+  }
+
+  // A first term left over on one side is a chain of the remaining terms of the other
+  if(count == other)
+    return equalViews(t[0], u[0]);
+  if(count == 1)
+    return t[0].kind == TermView::Kind::Element && equalChain(u, other, *t[0].element);
+  return u[0].kind == TermView::Kind::Element && equalChain(t, count, *u[0].element);
+}
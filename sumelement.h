@@ -0,0 +1,143 @@
+/**
+  * \file sumelement.h
+  * \brief Header for SumElement class
+  */
+#ifndef SUMELEMENT_H
+#define SUMELEMENT_H
+
+#include <memory>
+#include <vector>
+#include "cell.h"
+#include "element.h"
+#include "polynomialelement.h"
+
+/**
+  * \class SumElement
+  * \brief N-ary sum of terms. Reads, hashes and compares like the left-deep chain ((t0+t1)+t2)... of
+           CompositeElements it replaces, but is one node: evaluate is one loop over the terms and compile
+           emits flat code, so neither recurses along the chain
+  */
+class SumElement : public Element
+{
+public:
+  /**
+    * \brief Constructor for SumElement class referencing terms. Throws exception if there are fewer than
+             two terms or a term is missing
+    * \param terms Terms in order of summation
+    */
+  explicit SumElement(std::vector<std::shared_ptr<const Element>> terms);
+
+  /**
+    * \brief Virtual destructor for SumElement class
+    */
+  virtual ~SumElement() = default;
+
+  /**
+    * \brief Getter for number of terms
+    * \return Number of terms, at least two
+    */
+  virtual std::size_t count() const;
+
+  /**
+    * \brief Returns terms as shared elements
+    * \return Terms in order of summation
+    */
+  virtual std::vector<std::shared_ptr<const Element>> terms() const;
+
+  /**
+    * \brief Expands sum into polynomial, reusing and extending expansions in cache
+    * \param cache Expansions of elements converted earlier
+    * \return Polynomial equal to sum
+    */
+  virtual PolynomialElement polynomial(PolynomialElement::Cache& cache) const;
+
+  /**
+    * \brief Creates a clone of self and returns pointer to it. Clone shares terms with self
+    * \return Pointer to clone of self
+    */
+  Element* clone() const override;
+
+  /**
+    * \brief Returns sum in the string form of the chain of composites
+    * \return Sum in string form
+    */
+  std::string toString() const override;
+
+  /**
+    * \brief Sums values of terms, wrapping on overflow
+    * \param v Map for char variables and int values
+    * \return Int value of sum
+    */
+  int evaluate(const Valuation& v) const override;
+
+  /**
+    * \brief Appends instructions for the first term followed by each term and an addition to bytecode
+    * \param code Bytecode to be appended to
+    */
+  void compile(Bytecode& code) const override;
+
+  /**
+    * \brief Returns hash of the chain of composites, computed once at construction
+    * \return Hash of sum
+    */
+  std::size_t hash() const override{
+    return structuralHash;
+  };
+
+  /**
+    * \brief Compares to sums and chains of composites structurally once their hashes match. Terms are
+             matched from the last one, against the right operands along the chain of the other, or the
+             terms of the other sum, so neither strings nor composites for terms are built
+    * \param e Element to be compared to self
+    * \return True if e has the same string as self, else false
+    */
+  bool equals(const Element& e) const override;
+
+protected:
+  /**
+    * \brief Term of a sum as it is compared: an element, or an int, variable or product of two cells
+             of sums that do not keep their terms as elements
+    */
+  struct TermView{
+    enum class Kind : std::uint8_t{ Element, Int, Variable, Product };
+
+    Kind kind;
+    const Element* element;
+    const CellStorage* left;
+    const CellStorage* right;
+    Cell a;
+    Cell b;
+  };
+
+  /**
+    * \brief Returns terms to be compared, without creating elements for them
+    * \return Views of terms in order of summation
+    */
+  virtual std::vector<TermView> views() const;
+
+  /**
+    * \brief Constructor for sums computing their terms themselves
+    * \param hash Hash of the chain of composites of terms
+    */
+  explicit SumElement(std::size_t hash) : structuralHash{hash}{};
+
+  /**
+    * \brief Hash of chain extended by one term
+    * \param sum Hash of chain
+    * \param term Hash of term
+    * \return Hash of sum + term
+    */
+  static std::size_t extendHash(std::size_t sum, std::size_t term);
+
+private:
+  static bool equalViews(const TermView& t, const TermView& u);
+  static bool equalView(const TermView& t, const Element& e);
+  static bool equalChain(const std::vector<TermView>& t, std::size_t count, const Element& e);
+  static bool equalSums(const std::vector<TermView>& t, std::size_t count, const std::vector<TermView>& u, std::size_t other);
+
+  std::vector<std::shared_ptr<const Element>> items;
+  std::size_t structuralHash;
+
+};
+
+#endif // SUMELEMENT_H
@@ -0,0 +1,201 @@
+/**
+  * \file symbolicexpression.cpp
+  * \brief SymbolicExpression class
+  */
+
+#include <stdexcept>
+#include "symbolicexpression.h"
+
+/**
+  * \brief Node of expression graph. Leaves hold their matrix and its compiled program, other nodes their operands
+  */
+struct SymbolicExpression::Node
+{
+  Operation op;
+  unsigned int n;
+  SymbolicSquareMatrix matrix;
+  std::unique_ptr<const CompiledSquareMatrix> program;
+  std::shared_ptr<const Node> left;
+  std::shared_ptr<const Node> right;
+};
+
+SymbolicExpression::SymbolicExpression(SymbolicSquareMatrix m){
+
+  auto leaf = std::make_shared<Node>();
+  leaf->op = Operation::Leaf;
+  leaf->n = m.size();
+  leaf->program = std::make_unique<const CompiledSquareMatrix>(m);
+  leaf->matrix = std::move(m);
+
+  root = std::move(leaf);
+}
+
+SymbolicExpression::SymbolicExpression(Operation op, const SymbolicExpression& l, const SymbolicExpression& r){
+
+  if(l.size() != r.size())
+    throw std::invalid_argument{"Square matrices are not same size."};
+
+  auto node = std::make_shared<Node>();
+  node->op = op;
+  node->n = l.size();
+  node->left = l.root;
+  node->right = r.root;
+
+  root = std::move(node);
+}
+
+unsigned int SymbolicExpression::size() const{
+
+  return root->n;
+}
+
+SymbolicExpression::Operation SymbolicExpression::operation() const{
+
+  return root->op;
+}
+
+SymbolicExpression SymbolicExpression::operator+(const SymbolicExpression& e) const{
+
+  return SymbolicExpression{Operation::Add, *this, e};
+}
+
+SymbolicExpression SymbolicExpression::operator-(const SymbolicExpression& e) const{
+
+  return SymbolicExpression{Operation::Subtract, *this, e};
+}
+
+SymbolicExpression SymbolicExpression::operator*(const SymbolicExpression& e) const{
+
+  return SymbolicExpression{Operation::Multiply, *this, e};
+}
+
+void SymbolicExpression::count(const Node& e, Uses& uses){
+
+  // Operands are counted on the first visit only, so shared subexpressions are walked once
+  if(uses[&e]++ != 0 || e.op == Operation::Leaf)
+    return;
+
+  count(*e.left, uses);
+  count(*e.right, uses);
+}
+
+template <typename F>
+ConcreteSquareMatrix SymbolicExpression::value(const Node& e, Uses& uses, Values& values, F& leaf){
+
+  const bool last = --uses[&e] == 0;
+
+  auto found = values.find(&e);
+  if(found != values.end()){
+    if(!last)
+      return found->second;
+    ConcreteSquareMatrix result = std::move(found->second);
+    values.erase(found);
+    return result;
+  }
+
+  ConcreteSquareMatrix result{};
+
+  if(e.op == Operation::Leaf){
+    result = leaf(e);
+  }
+  else{
+    // Temporaries are computed into, so sums and differences allocate nothing
+    ConcreteSquareMatrix l = value(*e.left, uses, values, leaf);
+    const ConcreteSquareMatrix r = value(*e.right, uses, values, leaf);
+    switch(e.op){
+      case Operation::Add:
+        result = std::move(l) + r;
+        break;
+      case Operation::Subtract:
+        result = std::move(l) - r;
+        break;
+      default:
+        result = l * r;
+    }
+  }
+
+  if(!last)
+    values.emplace(&e, result);
+
+  return result;
+}
+
+ConcreteSquareMatrix SymbolicExpression::evaluate(const Valuation& val) const{
+
+  Uses uses;
+  Values values;
+  count(*root, uses);
+
+  auto leaf = [&](const Node& e){
+    return e.program->evaluate(val);
+  };
+
+  return value(*root, uses, values, leaf);
+}
+
+std::vector<ConcreteSquareMatrix> SymbolicExpression::evaluate(const ValuationBatch& batch) const{
+
+  Uses uses;
+  count(*root, uses);
+
+  // Every leaf is evaluated once for the whole batch, and each of its values is used by one run
+  std::unordered_map<const Node*, std::vector<ConcreteSquareMatrix>> leaves;
+  for(const auto& use : uses){
+    if(use.first->op == Operation::Leaf)
+      leaves.emplace(use.first, use.first->program->evaluate(batch));
+  }
+
+  std::vector<ConcreteSquareMatrix> results;
+  results.reserve(batch.size());
+
+  for(std::size_t k = 0; k < batch.size(); k++){
+    Uses remaining{uses};
+    Values values;
+    auto leaf = [&](const Node& e){
+      return std::move(leaves[&e][k]);
+    };
+    results.push_back(value(*root, remaining, values, leaf));
+  }
+
+  return results;
+}
+
+SymbolicSquareMatrix SymbolicExpression::expand() const{
+
+  // Shared subexpressions are expanded once
+  std::unordered_map<const Node*, SymbolicSquareMatrix> expanded;
+
+  auto expand = [&](const Node& e, auto& self) -> SymbolicSquareMatrix{
+    if(e.op == Operation::Leaf)
+      return e.matrix;
+
+    auto found = expanded.find(&e);
+    if(found != expanded.end())
+      return found->second;
+
+    SymbolicSquareMatrix l = self(*e.left, self);
+    const SymbolicSquareMatrix r = self(*e.right, self);
+    SymbolicSquareMatrix result{};
+    switch(e.op){
+      case Operation::Add:
+        result = std::move(l) + r;
+        break;
+      case Operation::Subtract:
+        result = std::move(l) - r;
+        break;
+      default:
+        result = std::move(l) * r;
+    }
+
+    expanded.emplace(&e, result);
+    return result;
+  };
+
+  return expand(*root, expand);
+}
+
+std::ostream& operator<<(std::ostream& os, const SymbolicExpression& e){
+
+  e.print(os);
+  return os;
+}
@@ -0,0 +1,151 @@
+/**
+  * \file symbolicexpression.h
+  * \brief Header for SymbolicExpression class
+  */
+#ifndef SYMBOLICEXPRESSION_H
+#define SYMBOLICEXPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "elementarymatrix.h"
+#include "compiledmatrix.h"
+
+/**
+  * \class SymbolicExpression
+  * \brief Matrix-level expression of SymbolicSquareMatrices: leaf matrices and +, - and * of whole matrices,
+           shared as an immutable graph. Operators only record operands, so a product costs O(1) instead of
+           expanding every cell into a sum of n products. evaluate compiles each leaf once, evaluates leaves
+           into ConcreteSquareMatrices and combines them with the concrete kernels, so a product of two
+           symbolic matrices is evaluated by one integer GEMM. Subexpressions used more than once are
+           evaluated once
+  */
+class SymbolicExpression
+{
+public:
+  /**
+    * \brief Operation of the root of expression
+    */
+  enum class Operation : std::uint8_t{ Leaf, Add, Subtract, Multiply };
+
+  /**
+    * \brief Constructor for leaf expression. Matrix is compiled once here
+    * \param m SymbolicSquareMatrix to be held
+    */
+  explicit SymbolicExpression(SymbolicSquareMatrix m);
+
+  /**
+    * \brief Getter for size
+    * \return Number of rows and columns
+    */
+  unsigned int size() const;
+
+  /**
+    * \brief Getter for operation of root
+    * \return Operation, Leaf for matrices
+    */
+  Operation operation() const;
+
+  /**
+    * \brief Operator overload for operator +
+    * \param e Expression to be summed
+    * \return Expression of sum. Throws exception if sizes differ
+    */
+  SymbolicExpression operator+(const SymbolicExpression& e) const;
+
+  /**
+    * \brief Operator overload for operator -
+    * \param e Expression to be subtracted
+    * \return Expression of difference. Throws exception if sizes differ
+    */
+  SymbolicExpression operator-(const SymbolicExpression& e) const;
+
+  /**
+    * \brief Operator overload for operator *
+    * \param e Expression to be multiplied by
+    * \return Expression of product. Throws exception if sizes differ
+    */
+  SymbolicExpression operator*(const SymbolicExpression& e) const;
+
+  /**
+    * \brief Evaluates leaves for mapped values and combines them with concrete operations
+    * \param val Map containing int values corresponding to char values
+    * \return ConcreteSquareMatrix equal to evaluating expand(). If no mapped value, throws exception
+    */
+  ConcreteSquareMatrix evaluate(const Valuation& val) const;
+
+  /**
+    * \brief Evaluates expression for every valuation of batch. Leaves are evaluated for the whole batch at once
+    * \param batch Valuations
+    * \return ConcreteSquareMatrix for every valuation, in order. If a variable is not mapped in every
+              valuation, throws exception
+    */
+  std::vector<ConcreteSquareMatrix> evaluate(const ValuationBatch& batch) const;
+
+  /**
+    * \brief Expands expression into SymbolicSquareMatrix with the symbolic operators
+    * \return SymbolicSquareMatrix equal to expression
+    */
+  SymbolicSquareMatrix expand() const;
+
+  /**
+    * \brief Returns expanded matrix in predetermined string format
+    * \return Matrix in predetermined string format
+    */
+  std::string toString() const{
+    return expand().toString();
+  };
+
+  /**
+    * \brief Prints toString() to output stream
+    * \param os Output stream
+    */
+  void print(std::ostream& os) const{
+
+    os << toString();
+  };
+
+private:
+  struct Node;
+  using Uses = std::unordered_map<const Node*, std::size_t>;
+  using Values = std::unordered_map<const Node*, ConcreteSquareMatrix>;
+
+  SymbolicExpression(Operation op, const SymbolicExpression& l, const SymbolicExpression& r);
+
+  /**
+    * \brief Counts references to every node reachable from e, so values are moved to their last user
+    */
+  static void count(const Node& e, Uses& uses);
+
+  /**
+    * \brief Evaluates node, taking values of leaves from leaf. Values used again are kept in values
+    */
+  template <typename F>
+  static ConcreteSquareMatrix value(const Node& e, Uses& uses, Values& values, F& leaf);
+
+  std::shared_ptr<const Node> root;
+
+};
+
+/**
+  * \brief Starts a symbolic expression
+  * \param m SymbolicSquareMatrix to be held
+  * \return Leaf expression of m
+  */
+inline SymbolicExpression lazy(const SymbolicSquareMatrix& m){
+  return SymbolicExpression{m};
+}
+
+/**
+  * \brief Operator overload for operator <<
+  * \param os Output stream
+  * \param e SymbolicExpression to be printed to output stream
+  * \return Output stream with expanded matrix printed
+  */
+std::ostream& operator<<(std::ostream& os, const SymbolicExpression& e);
+
+#endif // SYMBOLICEXPRESSION_H
@@ -0,0 +1,191 @@
+/**
+  * \file threadpool.cpp
+  * \brief ThreadPool class
+  */
+
+#include "threadpool.h"
+
+namespace{
+
+  // Set while the thread runs tasks, so nested parallelFor calls run serially instead of deadlocking
+  thread_local bool insideTask = false;
+
+  std::mutex sharedLock;
+  std::unique_ptr<ThreadPool> sharedPool;
+
+  unsigned int defaultThreadCount(){
+    unsigned int threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+  }
+
+}
+
+ThreadPool::ThreadPool(unsigned int threads) :
+participants{threads == 0 ? 1 : threads}, ranges{new Range[participants]}, job{nullptr},
+generation{0}, activeWorkers{0}, stopping{false}{
+
+  // The thread calling parallelFor is participant 0
+  for(unsigned int i = 1; i < participants; i++){
+    workers.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool(){
+
+  {
+    std::lock_guard<std::mutex> lock{jobLock};
+    stopping = true;
+  }
+  jobReady.notify_all();
+
+  for(auto& worker : workers){
+    worker.join();
+  }
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& task){
+
+  if(count == 0)
+    return;
+
+  if(participants == 1 || count == 1 || insideTask){
+    for(std::size_t i = 0; i < count; i++){
+      task(i);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> submit{submitLock};
+
+  // Contiguous initial split, stealing evens out the rest
+  for(unsigned int p = 0; p < participants; p++){
+    std::lock_guard<std::mutex> lock{ranges[p].lock};
+    ranges[p].begin = count * p / participants;
+    ranges[p].end = count * (p + 1) / participants;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{jobLock};
+    job = &task;
+    error = nullptr;
+    activeWorkers = participants - 1;
+    generation++;
+  }
+  jobReady.notify_all();
+
+  runTasks(0);
+
+  // A worker leaves runTasks only when no task is left to take or steal
+  std::unique_lock<std::mutex> lock{jobLock};
+  jobDone.wait(lock, [this]{ return activeWorkers == 0; });
+  job = nullptr;
+
+  if(error){
+    std::exception_ptr e = error;
+    error = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+ThreadPool& ThreadPool::shared(){
+
+  std::lock_guard<std::mutex> lock{sharedLock};
+
+  if(!sharedPool)
+    sharedPool.reset(new ThreadPool{defaultThreadCount()});
+
+  return *sharedPool;
+}
+
+void ThreadPool::setThreadCount(unsigned int threads){
+
+  std::lock_guard<std::mutex> lock{sharedLock};
+
+  sharedPool.reset(new ThreadPool{threads == 0 ? defaultThreadCount() : threads});
+}
+
+void ThreadPool::workerLoop(unsigned int self){
+
+  std::size_t seen = 0;
+
+  for(;;){
+    {
+      std::unique_lock<std::mutex> lock{jobLock};
+      jobReady.wait(lock, [this, seen]{ return stopping || generation != seen; });
+      if(stopping)
+        return;
+      seen = generation;
+    }
+
+    runTasks(self);
+
+    std::lock_guard<std::mutex> lock{jobLock};
+    activeWorkers--;
+    if(activeWorkers == 0)
+      jobDone.notify_one();
+  }
+}
+
+void ThreadPool::runTasks(unsigned int self){
+
+  insideTask = true;
+
+  for(;;){
+    std::size_t index;
+
+    if(!takeTask(self, index)){
+      if(!stealTasks(self))
+        break;
+      continue;
+    }
+
+    try{
+      (*job)(index);
+    }
+    catch(...){
+      std::lock_guard<std::mutex> lock{jobLock};
+      if(!error)
+        error = std::current_exception();
+    }
+  }
+
+  insideTask = false;
+}
+
+bool ThreadPool::takeTask(unsigned int self, std::size_t& index){
+
+  std::lock_guard<std::mutex> lock{ranges[self].lock};
+
+  if(ranges[self].begin == ranges[self].end)
+    return false;
+
+  index = ranges[self].begin++;
+  return true;
+}
+
+bool ThreadPool::stealTasks(unsigned int self){
+
+  for(unsigned int offset = 1; offset < participants; offset++){
+    Range& victim = ranges[(self + offset) % participants];
+    std::size_t begin;
+    std::size_t end;
+
+    {
+      std::lock_guard<std::mutex> lock{victim.lock};
+      if(victim.begin == victim.end)
+        continue;
+
+      // Taking the back half, victim keeps working from the front
+      begin = victim.begin + (victim.end - victim.begin) / 2;
+      end = victim.end;
+      victim.end = begin;
+    }
+
+    std::lock_guard<std::mutex> lock{ranges[self].lock};
+    ranges[self].begin = begin;
+    ranges[self].end = end;
+    return true;
+  }
+
+  return false;
+}
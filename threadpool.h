@@ -0,0 +1,104 @@
+/**
+  * \file threadpool.h
+  * \brief Header for ThreadPool class
+  */
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+  * \class ThreadPool
+  * \brief Fixed set of worker threads running indexed tasks. Every participant owns a range of task
+           indices and takes tasks from its front. A participant that runs out steals the back half of
+           another participant's range, so uneven tasks are balanced without a shared queue.
+  */
+class ThreadPool
+{
+public:
+  /**
+    * \brief Constructor for ThreadPool class
+    * \param threads Number of threads running tasks, including the thread calling parallelFor
+    */
+  explicit ThreadPool(unsigned int threads);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+    * \brief Destructor for ThreadPool class, joins workers
+    */
+  ~ThreadPool();
+
+  /**
+    * \brief Getter for number of threads
+    * \return Number of threads running tasks, including the calling thread
+    */
+  unsigned int size() const{
+    return participants;
+  };
+
+  /**
+    * \brief Runs task(i) once for every i in [0, count) and returns when all have finished.
+             Calls from inside a task run serially on the calling thread.
+             If a task throws, the first exception is rethrown to the caller.
+    * \param count Number of tasks
+    * \param task Function called with task index
+    */
+  void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task);
+
+  /**
+    * \brief Shared pool used by matrix operations. Created on first use
+    * \return Reference to shared pool
+    */
+  static ThreadPool& shared();
+
+  /**
+    * \brief Sets number of threads of shared pool. Must not be called while shared pool runs tasks
+    * \param threads Number of threads, 0 for one per hardware thread
+    */
+  static void setThreadCount(unsigned int threads);
+
+private:
+
+  /**
+    * \brief Task indices [begin, end) owned by one participant
+    */
+  struct Range{
+    std::mutex lock;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+  };
+
+  void workerLoop(unsigned int self);
+  void runTasks(unsigned int self);
+  bool takeTask(unsigned int self, std::size_t& index);
+  bool stealTasks(unsigned int self);
+
+  unsigned int participants;
+  std::vector<std::thread> workers;
+  std::unique_ptr<Range[]> ranges;
+
+  // Current job
+  std::mutex jobLock;
+  std::condition_variable jobReady;
+  std::condition_variable jobDone;
+  const std::function<void(std::size_t)>* job;
+  std::size_t generation;
+  unsigned int activeWorkers;
+  std::exception_ptr error;
+  bool stopping;
+
+  // Serializes parallelFor calls from different threads
+  std::mutex submitLock;
+
+};
+
+#endif // THREADPOOL_H
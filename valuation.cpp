@@ -0,0 +1,13 @@
+/**
+  * \file valuation.cpp
+  * \brief Valuation class
+  */
+
+#include "valuation.h"
+
+Valuation::Valuation(const std::map<char,int>& m) : Valuation{}{
+
+  for(auto& val : m){
+    (*this)[val.first] = val.second;
+  }
+}
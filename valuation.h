@@ -5,12 +5,197 @@
 #ifndef VALUATION_H
 #define VALUATION_H
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <stdexcept>
+#include <utility>
 
 /**
   * \class Valuation
-  * \brief Class for mapping char values to integer values
+  * \brief Class for mapping char values to integer values. Variables can only be A-Z or a-z, so values
+           are kept in a fixed array of 52 slots with a bitmask telling which slots are mapped
   */
-using Valuation = std::map<char,int>;
+class Valuation
+{
+public:
+  /**
+    * \brief Number of variables, A-Z and a-z
+    */
+  static constexpr std::size_t variableCount = 52;
 
-#endif // VALUATION_H
\ No newline at end of file
+  /**
+    * \class const_iterator
+    * \brief Iterates mapped variables in slot order, A-Z then a-z, as (variable, value) pairs
+    */
+  class const_iterator
+  {
+  public:
+    const_iterator(const Valuation* v, std::size_t s) : owner{v}, pos{s}{
+      skipUnmapped();
+    };
+
+    std::pair<char,int> operator*() const{
+      return std::pair<char,int>{name(pos), owner->vals[pos]};
+    };
+
+    const_iterator& operator++(){
+      pos++;
+      skipUnmapped();
+      return *this;
+    };
+
+    bool operator==(const const_iterator& it) const{
+      return pos == it.pos;
+    };
+
+    bool operator!=(const const_iterator& it) const{
+      return pos != it.pos;
+    };
+
+  private:
+    void skipUnmapped(){
+      while(pos < variableCount && !(owner->mapped >> pos & 1))
+        pos++;
+    };
+
+    const Valuation* owner;
+    std::size_t pos;
+  };
+
+  /**
+    * \brief Default constructor for Valuation class. No variable is mapped
+    */
+  Valuation() : vals{}, mapped{0}{};
+
+  /**
+    * \brief Constructor for Valuation class, copying mapped values of param. Throws exception for keys
+             that are not A-Z or a-z
+    * \param m Map for char variables and int values
+    */
+  Valuation(const std::map<char,int>& m);
+
+  /**
+    * \brief Returns value of variable, mapping it to 0 first if it is not mapped.
+             Throws exception if variable is not A-Z or a-z
+    * \param var Variable
+    * \return Reference to value of variable
+    */
+  int& operator[](char var){
+    const std::size_t s = slot(var);
+    if(s == variableCount)
+      throw std::invalid_argument{"Char needs to be A-Z or a-z."};
+    if(!(mapped >> s & 1)){
+      mapped |= std::uint64_t(1) << s;
+      vals[s] = 0;
+    }
+    return vals[s];
+  };
+
+  /**
+    * \brief Returns value of variable. Throws std::out_of_range if variable is not mapped
+    * \param var Variable
+    * \return Value of variable
+    */
+  int at(char var) const{
+    const std::size_t s = slot(var);
+    if(s == variableCount || !(mapped >> s & 1))
+      throw std::out_of_range{"Variable is not mapped."};
+    return vals[s];
+  };
+
+  /**
+    * \brief Checks whether variable is mapped
+    * \param var Variable
+    * \return 1 if variable is mapped, else 0
+    */
+  std::size_t count(char var) const{
+    const std::size_t s = slot(var);
+    return s != variableCount && (mapped >> s & 1) ? 1 : 0;
+  };
+
+  /**
+    * \brief Removes mapping of variable
+    * \param var Variable
+    * \return 1 if variable was mapped, else 0
+    */
+  std::size_t erase(char var){
+    const std::size_t n = count(var);
+    if(n != 0)
+      mapped &= ~(std::uint64_t(1) << slot(var));
+    return n;
+  };
+
+  /**
+    * \brief Getter for number of mapped variables
+    * \return Number of mapped variables
+    */
+  std::size_t size() const{
+    std::size_t n = 0;
+    for(std::uint64_t m = mapped; m != 0; m &= m - 1)
+      n++;
+    return n;
+  };
+
+  /**
+    * \brief Checks whether no variable is mapped
+    * \return True if no variable is mapped, else false
+    */
+  bool empty() const{
+    return mapped == 0;
+  };
+
+  /**
+    * \brief Getter for bitmask of mapped slots
+    * \return Bitmask with bit slot(var) set for every mapped variable
+    */
+  std::uint64_t mappedSlots() const{
+    return mapped;
+  };
+
+  /**
+    * \brief Getter for value in slot, regardless of whether it is mapped
+    * \param s Slot of variable
+    * \return Value in slot
+    */
+  int valueInSlot(std::size_t s) const{
+    return vals[s];
+  };
+
+  const_iterator begin() const{
+    return const_iterator{this, 0};
+  };
+
+  const_iterator end() const{
+    return const_iterator{this, variableCount};
+  };
+
+  /**
+    * \brief Returns slot of variable
+    * \param var Variable
+    * \return 0-25 for A-Z, 26-51 for a-z, variableCount for other chars
+    */
+  static std::size_t slot(char var){
+    if(var >= 'A' && var <= 'Z')
+      return std::size_t(var - 'A');
+    if(var >= 'a' && var <= 'z')
+      return std::size_t(var - 'a') + 26;
+    return variableCount;
+  };
+
+  /**
+    * \brief Returns variable of slot
+    * \param s Slot, 0-51
+    * \return Variable A-Z or a-z
+    */
+  static char name(std::size_t s){
+    return s < 26 ? char('A' + s) : char('a' + (s - 26));
+  };
+
+private:
+  int vals[variableCount];
+  std::uint64_t mapped;
+
+};
+
+#endif // VALUATION_H
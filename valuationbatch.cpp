@@ -0,0 +1,57 @@
+/**
+  * \file valuationbatch.cpp
+  * \brief ValuationBatch class
+  */
+
+#include <stdexcept>
+#include "valuationbatch.h"
+
+ValuationBatch::ValuationBatch(std::size_t count) : count{count}, mappedCount{}{}
+
+ValuationBatch::ValuationBatch(const std::vector<Valuation>& vals) : ValuationBatch{vals.size()}{
+
+  for(std::size_t i = 0; i < vals.size(); i++){
+    for(const auto& val : vals[i]){
+      set(val.first, i, val.second);
+    }
+  }
+}
+
+void ValuationBatch::set(char var, std::size_t index, int value){
+
+  if(index >= count)
+    throw std::out_of_range{"No valuation with that index."};
+
+  const std::size_t s = slot(var);
+
+  // Columns are allocated when variable is first mapped
+  if(columns[s].empty()){
+    columns[s].resize(count);
+    mapped[s].resize(count);
+  }
+
+  columns[s][index] = value;
+  if(!mapped[s][index]){
+    mapped[s][index] = true;
+    mappedCount[s]++;
+  }
+}
+
+const int* ValuationBatch::values(char var) const{
+
+  const std::size_t s = slot(var);
+
+  if(mappedCount[s] != count)
+    throw std::out_of_range{"Variable is not mapped in every valuation."};
+
+  return columns[s].data();
+}
+
+std::size_t ValuationBatch::slot(char var){
+
+  const std::size_t s = Valuation::slot(var);
+  if(s != variableCount)
+    return s;
+
+  throw std::invalid_argument{"Char needs to be A-Z or a-z."};
+}
@@ -0,0 +1,75 @@
+/**
+  * \file valuationbatch.h
+  * \brief Header for ValuationBatch class
+  */
+#ifndef VALUATIONBATCH_H
+#define VALUATIONBATCH_H
+
+#include <cstddef>
+#include <vector>
+#include "valuation.h"
+
+/**
+  * \class ValuationBatch
+  * \brief Many valuations stored as structure of arrays: for every variable, one contiguous column
+           holding its value in each valuation
+  */
+class ValuationBatch
+{
+public:
+  /**
+    * \brief Number of variables, A-Z and a-z
+    */
+  static constexpr std::size_t variableCount = Valuation::variableCount;
+
+  /**
+    * \brief Constructor for ValuationBatch class. No variable is mapped in any valuation
+    * \param count Number of valuations
+    */
+  explicit ValuationBatch(std::size_t count);
+
+  /**
+    * \brief Constructor for ValuationBatch class, transposing valuations into columns
+    * \param vals Valuations, in order
+    */
+  explicit ValuationBatch(const std::vector<Valuation>& vals);
+
+  /**
+    * \brief Getter for number of valuations
+    * \return Number of valuations
+    */
+  std::size_t size() const{
+    return count;
+  };
+
+  /**
+    * \brief Maps value to variable in one valuation. Throws exception if variable is not A-Z or a-z
+    * \param var Variable
+    * \param index Index of valuation
+    * \param value Value mapped to variable
+    */
+  void set(char var, std::size_t index, int value);
+
+  /**
+    * \brief Returns values of variable. Throws std::out_of_range unless variable is mapped in every valuation
+    * \param var Variable
+    * \return Pointer to size() values of variable, one per valuation
+    */
+  const int* values(char var) const;
+
+  /**
+    * \brief Returns slot of variable, A-Z to 0-25 and a-z to 26-51. Throws exception for other chars
+    * \param var Variable
+    * \return Slot of variable
+    */
+  static std::size_t slot(char var);
+
+private:
+  std::size_t count;
+  std::vector<int> columns[variableCount];
+  std::vector<bool> mapped[variableCount];
+  std::size_t mappedCount[variableCount];
+
+};
+
+#endif // VALUATIONBATCH_H
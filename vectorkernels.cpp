@@ -0,0 +1,145 @@
+/**
+  * \file vectorkernels.cpp
+  * \brief Elementwise int kernels with runtime CPU dispatch
+  */
+
+#include <cstdint>
+#include "vectorkernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VECTORKERNELS_X86
+#include <immintrin.h>
+#endif
+
+namespace{
+
+  using Kernel = void (*)(const int*, const int*, int*, std::size_t);
+
+  /**
+    * \brief Portable kernel, also handles tails of the vector kernels.
+             Unsigned arithmetic gives the wrap around of int without undefined behaviour
+    */
+  template <bool Subtract>
+  void kernelScalar(const int* a, const int* b, int* dst, std::size_t count){
+
+    for(std::size_t i = 0; i < count; i++){
+      const std::uint32_t x = std::uint32_t(a[i]);
+      const std::uint32_t y = std::uint32_t(b[i]);
+      dst[i] = int(Subtract ? x - y : x + y);
+    }
+  }
+
+#ifdef VECTORKERNELS_X86
+
+  template <bool Subtract>
+  __attribute__((target("sse2")))
+  void kernelSse2(const int* a, const int* b, int* dst, std::size_t count){
+
+    std::size_t i = 0;
+
+    for(; i + 4 <= count; i += 4){
+      const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+      const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), Subtract ? _mm_sub_epi32(x, y) : _mm_add_epi32(x, y));
+    }
+
+    kernelScalar<Subtract>(a + i, b + i, dst + i, count - i);
+  }
+
+  template <bool Subtract>
+  __attribute__((target("avx2")))
+  void kernelAvx2(const int* a, const int* b, int* dst, std::size_t count){
+
+    std::size_t i = 0;
+
+    for(; i + 8 <= count; i += 8){
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+      const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), Subtract ? _mm256_sub_epi32(x, y) : _mm256_add_epi32(x, y));
+    }
+
+    kernelScalar<Subtract>(a + i, b + i, dst + i, count - i);
+  }
+
+  template <bool Subtract>
+  __attribute__((target("avx512f")))
+  void kernelAvx512(const int* a, const int* b, int* dst, std::size_t count){
+
+    std::size_t i = 0;
+
+    for(; i + 16 <= count; i += 16){
+      const __m512i x = _mm512_loadu_si512(a + i);
+      const __m512i y = _mm512_loadu_si512(b + i);
+      _mm512_storeu_si512(dst + i, Subtract ? _mm512_sub_epi32(x, y) : _mm512_add_epi32(x, y));
+    }
+
+    kernelScalar<Subtract>(a + i, b + i, dst + i, count - i);
+  }
+
+#endif
+
+  /**
+    * \brief Returns kernel for the widest supported instruction set not wider than level
+    */
+  template <bool Subtract>
+  Kernel kernelFor(SimdLevel level){
+
+    if(level > supportedSimdLevel())
+      level = supportedSimdLevel();
+
+    switch(level){
+#ifdef VECTORKERNELS_X86
+      case SimdLevel::Avx512:
+        return kernelAvx512<Subtract>;
+      case SimdLevel::Avx2:
+        return kernelAvx2<Subtract>;
+      case SimdLevel::Sse2:
+        return kernelSse2<Subtract>;
+#endif
+      default:
+        return kernelScalar<Subtract>;
+    }
+  }
+
+}
+
+SimdLevel supportedSimdLevel(){
+
+#ifdef VECTORKERNELS_X86
+  static const SimdLevel level = []{
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+      return SimdLevel::Avx512;
+    if(__builtin_cpu_supports("avx2"))
+      return SimdLevel::Avx2;
+    if(__builtin_cpu_supports("sse2"))
+      return SimdLevel::Sse2;
+    return SimdLevel::Scalar;
+  }();
+  return level;
+#else
+  return SimdLevel::Scalar;
+#endif
+}
+
+void addInts(const int* a, const int* b, int* dst, std::size_t count){
+
+  static const Kernel kernel = kernelFor<false>(SimdLevel::Avx512);
+  kernel(a, b, dst, count);
+}
+
+void subtractInts(const int* a, const int* b, int* dst, std::size_t count){
+
+  static const Kernel kernel = kernelFor<true>(SimdLevel::Avx512);
+  kernel(a, b, dst, count);
+}
+
+void addInts(const int* a, const int* b, int* dst, std::size_t count, SimdLevel level){
+
+  kernelFor<false>(level)(a, b, dst, count);
+}
+
+void subtractInts(const int* a, const int* b, int* dst, std::size_t count, SimdLevel level){
+
+  kernelFor<true>(level)(a, b, dst, count);
+}
@@ -0,0 +1,56 @@
+/**
+  * \file vectorkernels.h
+  * \brief Header for elementwise int kernels with runtime CPU dispatch
+  */
+#ifndef VECTORKERNELS_H
+#define VECTORKERNELS_H
+
+#include <cstddef>
+
+/**
+  * \brief Instruction sets the kernels are written for, from narrowest to widest
+  */
+enum class SimdLevel{
+  Scalar,
+  Sse2,
+  Avx2,
+  Avx512
+};
+
+/**
+  * \brief Detects the widest instruction set supported by the running CPU. Detected once
+  * \return Widest supported SimdLevel
+  */
+SimdLevel supportedSimdLevel();
+
+/**
+  * \brief Adds a and b elementwise into dst, wrapping around like int arithmetic.
+           dst may be the same buffer as a or b
+  * \param a First operand
+  * \param b Second operand
+  * \param dst Result
+  * \param count Number of ints
+  */
+void addInts(const int* a, const int* b, int* dst, std::size_t count);
+
+/**
+  * \brief Subtracts b from a elementwise into dst, wrapping around like int arithmetic.
+           dst may be the same buffer as a or b
+  * \param a First operand
+  * \param b Second operand
+  * \param dst Result
+  * \param count Number of ints
+  */
+void subtractInts(const int* a, const int* b, int* dst, std::size_t count);
+
+/**
+  * \brief Same as addInts, but uses the kernel for level, or the widest supported one below it
+  */
+void addInts(const int* a, const int* b, int* dst, std::size_t count, SimdLevel level);
+
+/**
+  * \brief Same as subtractInts, but uses the kernel for level, or the widest supported one below it
+  */
+void subtractInts(const int* a, const int* b, int* dst, std::size_t count, SimdLevel level);
+
+#endif // VECTORKERNELS_H